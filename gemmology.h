@@ -3,13 +3,21 @@
 
 #include "gemmology_fwd.h"
 
+#include <cmath>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <tuple>
+#include <type_traits>
+#include <vector>
 
 #ifdef GEMMOLOGY_WITH_STD_THREAD
 #include <thread>
-#include <vector>
+#endif
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__) && defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
 #endif
 
 #include <xsimd/xsimd.hpp>
@@ -94,11 +102,26 @@ template <class Arch>
 inline xsimd::batch<int16_t, Arch>
 madd(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
      xsimd::kernel::requires_arch<xsimd::avx512bw>) {
-  return _mm512_madd_epi16(x, y);
-}
+  // No _mm512_sign_epi8: negate y where x is negative.
+  __mmask64 neg = _mm512_movepi8_mask(x);
+  return _mm512_maddubs_epi16(
+      _mm512_abs_epi8(x),
+      _mm512_mask_sub_epi8(y, neg, _mm512_setzero_si512(), y));
+}
+
+/* Architecture of the 8 totals of a block of columns, which only fill half of
+ * an AVX512 register. Architectures derived from AVX512 may name their own
+ * half_arch, as gemmology_dispatch.cpp does. */
+template <class Arch, class = void> struct HalfArch {
+  using type = xsimd::avx2;
+};
+template <class Arch>
+struct HalfArch<Arch, std::void_t<typename Arch::half_arch>> {
+  using type = typename Arch::half_arch;
+};
 
 template <class Arch>
-inline xsimd::batch<int32_t, xsimd::avx2>
+inline xsimd::batch<int32_t, typename HalfArch<Arch>::type>
 PermuteSummer(xsimd::batch<int32_t, Arch> pack0123,
               xsimd::batch<int32_t, Arch> pack4567,
               xsimd::kernel::requires_arch<xsimd::avx512bw>) {
@@ -223,6 +246,25 @@ maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
       xsimd::kernel::requires_arch<xsimd::avxvnni>) {
   return _mm256_dpbusd_avx_epi32(z, x, y);
 }
+
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<xsimd::avxvnni>) {
+  return _mm256_dpbusd_avx_epi32(z, _mm256_abs_epi8(x), _mm256_sign_epi8(y, x));
+}
+#endif
+
+#ifdef __AVXVNNIINT8__
+
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<avxvnniint8>) {
+  return _mm256_dpbssd_epi32(z, x, y);
+}
 #endif
 
 #ifdef __AVX512VNNI__
@@ -235,6 +277,17 @@ maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
   return _mm512_dpbusd_epi32(z, x, y);
 }
 
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<xsimd::avx512vnni<xsimd::avx512bw>>) {
+  __mmask64 neg = _mm512_movepi8_mask(x);
+  return _mm512_dpbusd_epi32(
+      z, _mm512_abs_epi8(x),
+      _mm512_mask_sub_epi8(y, neg, _mm512_setzero_si512(), y));
+}
+
 template <class Arch>
 inline xsimd::batch<int32_t, Arch>
 maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
@@ -242,6 +295,28 @@ maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
       xsimd::kernel::requires_arch<xsimd::avx512vnni<xsimd::avx512vbmi>>) {
   return _mm512_dpbusd_epi32(z, x, y);
 }
+
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<xsimd::avx512vnni<xsimd::avx512vbmi>>) {
+  __mmask64 neg = _mm512_movepi8_mask(x);
+  return _mm512_dpbusd_epi32(
+      z, _mm512_abs_epi8(x),
+      _mm512_mask_sub_epi8(y, neg, _mm512_setzero_si512(), y));
+}
+#endif
+
+#ifdef __AVX10_2__
+
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<avx10_2>) {
+  return _mm512_dpbssd_epi32(z, x, y);
+}
 #endif
 
 #endif
@@ -596,6 +671,20 @@ maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
   return vpadalq_s16(vpaddlq_s16(tl), th);
 }
 
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<xsimd::neon64>) {
+#ifdef __ARM_FEATURE_DOTPROD
+  return vdotq_s32(z, x, y);
+#else
+  int16x8_t tl = vmull_s8(vget_low_s8(x), vget_low_s8(y));
+  int16x8_t th = vmull_high_s8(x, y);
+  return vpadalq_s16(vpadalq_s16(z, tl), th);
+#endif
+}
+
 template <class Arch>
 inline xsimd::batch<int32_t, Arch> Pack0123(xsimd::batch<int32_t, Arch> sum0,
                                       xsimd::batch<int32_t, Arch> sum1,
@@ -624,6 +713,21 @@ maddw(xsimd::batch<uint8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
   return maddw(x, y, xsimd::batch<int32_t, Arch>(0), Arch{});
 }
 
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::batch<int32_t, Arch> z,
+      xsimd::kernel::requires_arch<xsimd::generic>) {
+  return z + madd(xsimd::batch<int16_t, Arch>(1), madd(x, y, Arch{}), Arch{});
+}
+
+template <class Arch>
+inline xsimd::batch<int32_t, Arch>
+maddw(xsimd::batch<int8_t, Arch> x, xsimd::batch<int8_t, Arch> y,
+      xsimd::kernel::requires_arch<xsimd::generic>) {
+  return maddw(x, y, xsimd::batch<int32_t, Arch>(0), Arch{});
+}
+
 } // namespace kernel
 
 //
@@ -675,6 +779,19 @@ inline xsimd::batch<int32_t, Arch> maddw(xsimd::batch<uint8_t, Arch> x,
                                          ) {
   return kernel::maddw(x, y, Arch{});
 }
+template <class Arch>
+inline xsimd::batch<int32_t, Arch> maddw(xsimd::batch<int8_t, Arch> x,
+                                         xsimd::batch<int8_t, Arch> y,
+                                         xsimd::batch<int32_t, Arch> z
+                                         ) {
+  return kernel::maddw(x, y, z, Arch{});
+}
+template <class Arch>
+inline xsimd::batch<int32_t, Arch> maddw(xsimd::batch<int8_t, Arch> x,
+                                         xsimd::batch<int8_t, Arch> y
+                                         ) {
+  return kernel::maddw(x, y, Arch{});
+}
 
 template <class Arch>
 inline auto PermuteSummer(xsimd::batch<int32_t, Arch> pack0123,
@@ -782,25 +899,6 @@ public:
                  input + 3 * xsimd::batch<float, Arch>::size);
   }
 
-  template <class Arch>
-  static inline xsimd::batch<int8_t, Arch>
-  ConsecutiveWithWrapping(xsimd::batch<float, Arch> quant_mult,
-                          const float *input, size_t cols_left, size_t cols,
-                          size_t row_step) {
-    using batchf32 = xsimd::batch<float, Arch>;
-    const float *inputs[4];
-    for (size_t i = 0; i < std::size(inputs); ++i) {
-      while (cols_left < batchf32::size) {
-        input += cols * (row_step - 1);
-        cols_left += cols;
-      }
-      inputs[i] = input;
-      input += batchf32::size;
-      cols_left -= batchf32::size;
-    }
-    return Tile(quant_mult, inputs[0], inputs[1], inputs[2], inputs[3]);
-  }
-
   template <class Arch>
   static inline xsimd::batch<int8_t, Arch>
   ForReshape(xsimd::batch<float, Arch> quant_mult, const float *input,
@@ -1003,6 +1101,14 @@ inline void Transpose16InLane(
   std::swap(r3, r6);
 }
 
+/* Width of the prepared matrices: the shared dimension rounded up to a whole
+ * number of registers, rows of A being padded with zeros and so are rows of
+ * B, so that the padding does not contribute to the dot products. */
+template <class Arch> constexpr size_t PaddedWidth(size_t width) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  return (width + batch8::size - 1) / batch8::size * batch8::size;
+}
+
 template <class Arch, typename IntegerTy>
 void SelectColumnsOfB(const xsimd::batch<int8_t, Arch> *input,
                       xsimd::batch<int8_t, Arch> *output,
@@ -1010,9 +1116,9 @@ void SelectColumnsOfB(const xsimd::batch<int8_t, Arch> *input,
                       const IntegerTy *cols_begin, const IntegerTy *cols_end) {
   using batch8 = xsimd::batch<int8_t, Arch>;
   /* Do columns for multiples of 8.*/
-  size_t register_rows = rows_bytes / batch8::size;
+  size_t register_rows = PaddedWidth<Arch>(rows_bytes) / batch8::size;
   const batch8 *starts[8];
-  for (; cols_begin != cols_end; cols_begin += 8) {
+  for (; cols_end - cols_begin >= 8; cols_begin += 8) {
     for (size_t k = 0; k < 8; ++k) {
       starts[k] =
           input + (cols_begin[k] & 7) + (cols_begin[k] & ~7) * register_rows;
@@ -1024,8 +1130,152 @@ void SelectColumnsOfB(const xsimd::batch<int8_t, Arch> *input,
       }
     }
   }
+  /* The remaining columns, if any, make a last block padded with zeros, as for
+   * PrepareB. */
+  const size_t remaining = cols_end - cols_begin;
+  if (!remaining)
+    return;
+  for (size_t k = 0; k < remaining; ++k) {
+    starts[k] =
+        input + (cols_begin[k] & 7) + (cols_begin[k] & ~7) * register_rows;
+  }
+  for (size_t r = 0; r < register_rows; ++r) {
+    for (size_t k = 0; k < 8; ++k) {
+      if (k < remaining) {
+        *(output++) = *starts[k];
+        starts[k] += 8;
+      } else {
+        *(output++) = batch8(0);
+      }
+    }
+  }
+}
+
+/* Store the first count floats of result to output, count being at most the
+ * size of a batch. Full batches go straight to memory, aligned or not, others
+ * through a local buffer so that nothing past output + count gets written. */
+template <class Arch>
+inline void StoreColumns(xsimd::batch<float, Arch> result, float *output,
+                         size_t count, bool aligned) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  if (count >= batchf32::size) {
+    if (aligned)
+      result.store_aligned(output);
+    else
+      result.store_unaligned(output);
+    return;
+  }
+  alignas(Arch::alignment()) float buffer[batchf32::size];
+  result.store_aligned(buffer);
+  std::memcpy(output, buffer, count * sizeof(float));
+}
+
+/* Load the first count floats of input, count being at most the size of a
+ * batch, the other lanes being zero. */
+template <class Arch>
+inline xsimd::batch<float, Arch> LoadColumns(const float *input, size_t count,
+                                             bool aligned) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  if (count >= batchf32::size)
+    return aligned ? batchf32::load_aligned(input)
+                   : batchf32::load_unaligned(input);
+  alignas(Arch::alignment()) float buffer[batchf32::size] = {};
+  std::memcpy(buffer, input, count * sizeof(float));
+  return batchf32::load_aligned(buffer);
+}
+
+/* Quantize the first count floats of input as QuantizeU does, count being at
+ * most the size of a batch. */
+template <class Arch>
+inline void StoreQuantizedU(xsimd::batch<float, Arch> input, float quant_mult,
+                            uint8_t *output, size_t count) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+  /* Clip before converting, rather than saturating the integers like
+   * QuantizeTile8, as a callback only gets a few columns at a time. NaN does
+   * not go through the clip the way it goes through the conversion of
+   * QuantizeU, so first replace it with what QuantizeU makes of it. */
+  const batchf32 nan_quantized = xsimd::batch_cast<float>(xsimd::clip(
+      xsimd::nearbyint_as_int(
+          batchf32(std::numeric_limits<float>::quiet_NaN())),
+      batch32(-127), batch32(127)));
+  batchf32 scaled = input * quant_mult;
+  auto clipped = xsimd::clip(
+      xsimd::select(xsimd::isnan(scaled), nan_quantized, scaled),
+      batchf32(-127.f), batchf32(127.f));
+  batch32 shifted = xsimd::nearbyint_as_int(clipped) + 127;
+  alignas(Arch::alignment()) int32_t buffer[batch32::size];
+  shifted.store_aligned(buffer);
+  for (size_t i = 0; i < std::min(count, batch32::size); ++i)
+    output[i] = static_cast<uint8_t>(buffer[i]);
+}
+
+/* Largest absolute value of the size floats of input. */
+template <class Arch>
+inline float MaxAbsoluteOf(const float *input, size_t size) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  const size_t fast_end = size / batchf32::size * batchf32::size;
+  batchf32 highest(0.f);
+  for (size_t i = 0; i < fast_end; i += batchf32::size)
+    highest = xsimd::max(highest,
+                         xsimd::abs(batchf32::load_unaligned(input + i)));
+  float result = xsimd::reduce_max(highest);
+  for (size_t i = fast_end; i < size; ++i)
+    result = std::max(result, std::fabs(input[i]));
+  return result;
+}
+
+/* Smallest and largest of the size floats of input. */
+template <class Arch>
+inline std::pair<float, float> MinMaxOf(const float *input, size_t size) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  const size_t fast_end = size / batchf32::size * batchf32::size;
+  batchf32 lowest(std::numeric_limits<float>::infinity());
+  batchf32 highest(-std::numeric_limits<float>::infinity());
+  for (size_t i = 0; i < fast_end; i += batchf32::size) {
+    auto values = batchf32::load_unaligned(input + i);
+    lowest = xsimd::min(lowest, values);
+    highest = xsimd::max(highest, values);
+  }
+  float low = xsimd::reduce_min(lowest);
+  float high = xsimd::reduce_max(highest);
+  for (size_t i = fast_end; i < size; ++i) {
+    low = std::min(low, input[i]);
+    high = std::max(high, input[i]);
+  }
+  return {low, high};
+}
+
+/* Sum and sum of squares of the size floats of input, or of their absolute
+ * values, which only changes the former. */
+template <class Arch>
+inline std::pair<double, double> SumsOf(const float *input, size_t size,
+                                        bool absolute) {
+  using batchf32 = xsimd::batch<float, Arch>;
+  const size_t fast_end = size / batchf32::size * batchf32::size;
+  batchf32 sum(0.f), squares(0.f);
+  for (size_t i = 0; i < fast_end; i += batchf32::size) {
+    auto values = batchf32::load_unaligned(input + i);
+    if (absolute)
+      values = xsimd::abs(values);
+    sum += values;
+    squares += values * values;
+  }
+  double total = xsimd::reduce_add(sum);
+  double total_squares = xsimd::reduce_add(squares);
+  for (size_t i = fast_end; i < size; ++i) {
+    const double value = absolute ? std::fabs(input[i]) : input[i];
+    total += value;
+    total_squares += value * value;
+  }
+  return {total, total_squares};
 }
 
+/* Number of floats per task of the statistics routines: large enough for
+ * the overhead of a task to vanish, small enough for partial sums in float
+ * to stay accurate. */
+constexpr size_t kStatisticsChunk = 16384;
+
 } // namespace
 
 namespace callbacks {
@@ -1044,72 +1294,339 @@ std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> Unquantize::ope
       xsimd::batch_cast<float>(std::get<1>(total)) * unquant_mult);
 }
 
+template <class Mode>
 template <class Arch>
-xsimd::batch<float, Arch> AddBias::operator()(xsimd::batch<float, Arch> total, size_t,
-                         size_t col_idx, size_t) {
-  return total + xsimd::batch<float, Arch>::load_aligned(bias_addr + col_idx);
+xsimd::batch<float, Arch>
+BasicUnquantizePerColumn<Mode>::operator()(xsimd::batch<int32_t, Arch> total,
+                                           size_t, size_t col_idx,
+                                           size_t col_size) {
+  constexpr bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value;
+  return xsimd::batch_cast<float>(total) *
+         LoadColumns<Arch>(unquant_mults + col_idx, col_size - col_idx,
+                           aligned);
 }
 
+template <class Mode>
 template <class Arch>
 std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
-AddBias::operator()(
+BasicUnquantizePerColumn<Mode>::operator()(
+    std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      col_size - col_idx > size
+          ? (*this)(std::get<1>(total), row_idx, col_idx + size, col_size)
+          : xsimd::batch<float, Arch>(0.f));
+}
+
+template <class Mode>
+template <class Arch>
+xsimd::batch<float, Arch> BasicUnquantizePerRowAndColumn<Mode>::operator()(
+    xsimd::batch<int32_t, Arch> total, size_t row_idx, size_t col_idx,
+    size_t col_size) {
+  constexpr bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value;
+  const size_t count = col_size - col_idx;
+  auto col_mults =
+      LoadColumns<Arch>(col_unquant_mults + col_idx, count, aligned);
+  auto correction =
+      LoadColumns<Arch>(shift_correction + col_idx, count, aligned);
+  return (xsimd::batch_cast<float>(total) * col_mults + correction) *
+         row_unquant_mults[row_idx];
+}
+
+template <class Mode>
+template <class Arch>
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+BasicUnquantizePerRowAndColumn<Mode>::operator()(
+    std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      col_size - col_idx > size
+          ? (*this)(std::get<1>(total), row_idx, col_idx + size, col_size)
+          : xsimd::batch<float, Arch>(0.f));
+}
+
+template <class Mode>
+template <class Arch>
+xsimd::batch<float, Arch>
+BasicAddBias<Mode>::operator()(xsimd::batch<float, Arch> total, size_t,
+                               size_t col_idx, size_t col_size) {
+  constexpr bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value;
+  return total +
+         LoadColumns<Arch>(bias_addr + col_idx, col_size - col_idx, aligned);
+}
+
+template <class Mode>
+template <class Arch>
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+BasicAddBias<Mode>::operator()(
     std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
-    size_t, size_t col_idx, size_t) {
+    size_t, size_t col_idx, size_t col_size) {
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  constexpr bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value;
+  const size_t count = col_size - col_idx;
   return std::make_tuple(
-      std::get<0>(total) + xsimd::batch<float, Arch>::load_aligned(bias_addr + col_idx + 0),
+      std::get<0>(total) +
+          LoadColumns<Arch>(bias_addr + col_idx, count, aligned),
       std::get<1>(total) +
-          xsimd::batch<float, Arch>::load_aligned(bias_addr + col_idx +
-                              xsimd::batch<float, Arch>::size));
+          LoadColumns<Arch>(bias_addr + col_idx + size,
+                            count > size ? count - size : 0, aligned));
+}
+
+template <class Arch>
+xsimd::batch<float, Arch> ReLU::operator()(xsimd::batch<float, Arch> total,
+                                           size_t, size_t, size_t) {
+  return xsimd::max(total, xsimd::batch<float, Arch>(0.f));
+}
+
+template <class Arch>
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+ReLU::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      (*this)(std::get<1>(total), row_idx, col_idx, col_size));
+}
+
+template <class Arch>
+xsimd::batch<float, Arch> GELU::operator()(xsimd::batch<float, Arch> total,
+                                           size_t, size_t, size_t) {
+  return 0.5f * total * (1.f + xsimd::erf(total * 0.70710678f));
+}
+
+template <class Arch>
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+GELU::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      (*this)(std::get<1>(total), row_idx, col_idx, col_size));
+}
+
+template <class Arch>
+xsimd::batch<float, Arch> GELUTanh::operator()(xsimd::batch<float, Arch> total,
+                                               size_t, size_t, size_t) {
+  const auto inner = 0.79788456f * (total + 0.044715f * total * total * total);
+  return 0.5f * total * (1.f + xsimd::tanh(inner));
 }
 
 template <class Arch>
-void Write::operator()(xsimd::batch<float, Arch> result, size_t row_idx,
-                       size_t col_idx, size_t col_size) {
-  result.store_aligned(output_addr + row_idx * col_size + col_idx);
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+GELUTanh::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      (*this)(std::get<1>(total), row_idx, col_idx, col_size));
+}
+
+template <class Arch>
+xsimd::batch<float, Arch> SiLU::operator()(xsimd::batch<float, Arch> total,
+                                           size_t, size_t, size_t) {
+  return total / (1.f + xsimd::exp(-total));
+}
+
+template <class Arch>
+std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
+SiLU::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  return std::make_tuple(
+      (*this)(std::get<0>(total), row_idx, col_idx, col_size),
+      (*this)(std::get<1>(total), row_idx, col_idx, col_size));
 }
 
+/* In aligned mode, a dense output with B_cols a multiple of 8 keeps every row
+ * aligned; other widths, and strided outputs which may start anywhere, get
+ * unaligned stores. The last block of each row only writes the columns that
+ * exist. */
+template <class Mode>
 template <class Arch>
-void Write::operator()(xsimd::batch<int32_t, Arch> result, size_t row_idx,
-                       size_t col_idx, size_t col_size) {
-  xsimd::bitwise_cast<float>(result).store_aligned(
-      output_addr + row_idx * col_size + col_idx);
+void BasicWrite<Mode>::operator()(xsimd::batch<float, Arch> result,
+                                  size_t row_idx, size_t col_idx,
+                                  size_t col_size) {
+  const bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value &&
+                       !ldc && col_size % 8 == 0;
+  StoreColumns(result, output_addr + row_idx * (ldc ? ldc : col_size) + col_idx,
+               col_size - col_idx, aligned);
 }
 
+template <class Mode>
 template <class Arch>
-void Write::operator()(
+void BasicWrite<Mode>::operator()(xsimd::batch<int32_t, Arch> result,
+                                  size_t row_idx, size_t col_idx,
+                                  size_t col_size) {
+  (*this)(xsimd::bitwise_cast<float>(result), row_idx, col_idx, col_size);
+}
+
+template <class Mode>
+template <class Arch>
+void BasicWrite<Mode>::operator()(
     std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> result,
     size_t row_idx, size_t col_idx, size_t col_size) {
-  std::get<0>(result).store_aligned(output_addr + row_idx * col_size + col_idx +
-                                    0);
-  std::get<1>(result).store_aligned(output_addr + row_idx * col_size + col_idx +
-                                    xsimd::batch<float, Arch>::size);
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  const size_t count = col_size - col_idx;
+  const bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value &&
+                       !ldc && col_size % 8 == 0;
+  float *output = output_addr + row_idx * (ldc ? ldc : col_size) + col_idx;
+  StoreColumns(std::get<0>(result), output, count, aligned);
+  if (count > size)
+    StoreColumns(std::get<1>(result), output + size, count - size, aligned);
 }
 
+template <class Mode>
 template <class Arch>
-void Write::operator()(
+void BasicWrite<Mode>::operator()(
     std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>> result,
     size_t row_idx, size_t col_idx, size_t col_size) {
-  xsimd::bitwise_cast<float>(std::get<0>(result))
-      .store_aligned(output_addr + row_idx * col_size + col_idx + 0);
-  xsimd::bitwise_cast<float>(std::get<1>(result))
-      .store_aligned(output_addr + row_idx * col_size + col_idx +
-                     xsimd::batch<int32_t, Arch>::size);
+  (*this)(std::make_tuple(xsimd::bitwise_cast<float>(std::get<0>(result)),
+                          xsimd::bitwise_cast<float>(std::get<1>(result))),
+          row_idx, col_idx, col_size);
+}
+
+template <class Arch>
+void QuantizeUAndWrite::operator()(xsimd::batch<float, Arch> result,
+                                   size_t row_idx, size_t col_idx,
+                                   size_t col_size) {
+  StoreQuantizedU(result, quant_mult, output_addr + row_idx * ldc + col_idx,
+                  col_size - col_idx);
+}
+
+template <class Arch>
+void QuantizeUAndWrite::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> result,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  const size_t count = col_size - col_idx;
+  uint8_t *output = output_addr + row_idx * ldc + col_idx;
+  StoreQuantizedU(std::get<0>(result), quant_mult, output, count);
+  if (count > size)
+    StoreQuantizedU(std::get<1>(result), quant_mult, output + size,
+                    count - size);
+}
+
+/* Same alignment rules as Write, the output being read then written. */
+template <class Mode>
+template <class Arch>
+void BasicAccumulate<Mode>::operator()(xsimd::batch<float, Arch> result,
+                                       size_t row_idx, size_t col_idx,
+                                       size_t col_size) {
+  const size_t count = col_size - col_idx;
+  const bool aligned = std::is_same<Mode, xsimd::aligned_mode>::value &&
+                       !ldc && col_size % 8 == 0;
+  float *output = output_addr + row_idx * (ldc ? ldc : col_size) + col_idx;
+  /* C is not read at all with beta 0, so that it may hold anything, NaN
+   * included, as for Write. */
+  if (beta == 0.f) {
+    StoreColumns(result, output, count, aligned);
+    return;
+  }
+  auto previous = LoadColumns<Arch>(output, count, aligned);
+  StoreColumns(previous * beta + result, output, count, aligned);
+}
+
+template <class Mode>
+template <class Arch>
+void BasicAccumulate<Mode>::operator()(
+    std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> result,
+    size_t row_idx, size_t col_idx, size_t col_size) {
+  constexpr size_t size = xsimd::batch<float, Arch>::size;
+  (*this)(std::get<0>(result), row_idx, col_idx, col_size);
+  if (col_size - col_idx > size)
+    (*this)(std::get<1>(result), row_idx, col_idx + size, col_size);
+}
+
+template <class Mode>
+template <class T>
+void BasicUnquantizeAndWrite<Mode>::operator()(T const &total, size_t row_idx,
+                                               size_t col_idx,
+                                               size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  write(unquantized, row_idx, col_idx, col_size);
 }
 
+template <class Mode>
 template <class T>
-void UnquantizeAndWrite::operator()(T const &total, size_t row_idx,
-                                    size_t col_idx, size_t col_size) {
+void BasicUnquantizePerColumnAndWrite<Mode>::operator()(T const &total,
+                                                        size_t row_idx,
+                                                        size_t col_idx,
+                                                        size_t col_size) {
   auto unquantized = unquantize(total, row_idx, col_idx, col_size);
   write(unquantized, row_idx, col_idx, col_size);
 }
 
+template <class Mode>
 template <class T>
-void UnquantizeAndAddBiasAndWrite::operator()(T const &total, size_t row_idx,
-                                              size_t col_idx, size_t col_size) {
+void BasicUnquantizePerColumnAndAddBiasAndWrite<Mode>::operator()(
+    T const &total, size_t row_idx, size_t col_idx, size_t col_size) {
   auto unquantized = unquantize(total, row_idx, col_idx, col_size);
   auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
   write(bias_added, row_idx, col_idx, col_size);
 }
+
+template <class Mode>
+template <class T>
+void BasicUnquantizePerRowAndColumnAndAddBiasAndWrite<Mode>::operator()(
+    T const &total, size_t row_idx, size_t col_idx, size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
+  write(bias_added, row_idx, col_idx, col_size);
+}
+
+template <class Mode>
+template <class T>
+void BasicUnquantizeAndAddBiasAndWrite<Mode>::operator()(T const &total,
+                                                         size_t row_idx,
+                                                         size_t col_idx,
+                                                         size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
+  write(bias_added, row_idx, col_idx, col_size);
+}
+
+template <class Mode>
+template <class T>
+void BasicUnquantizeAndAccumulate<Mode>::operator()(T const &total,
+                                                    size_t row_idx,
+                                                    size_t col_idx,
+                                                    size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  accumulate(unquantized, row_idx, col_idx, col_size);
+}
+
+template <class Mode>
+template <class T>
+void BasicUnquantizeAndAddBiasAndAccumulate<Mode>::operator()(
+    T const &total, size_t row_idx, size_t col_idx, size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
+  accumulate(bias_added, row_idx, col_idx, col_size);
+}
+
+template <class Activation, class Mode>
+template <class T>
+void BasicUnquantizeAndAddBiasAndActivateAndWrite<Activation, Mode>::operator()(
+    T const &total, size_t row_idx, size_t col_idx, size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
+  auto activated = activate(bias_added, row_idx, col_idx, col_size);
+  write(activated, row_idx, col_idx, col_size);
+}
+
+template <class Activation, class Mode>
+template <class T>
+void UnquantizeAndAddBiasAndRequantize<Activation, Mode>::operator()(
+    T const &total, size_t row_idx, size_t col_idx, size_t col_size) {
+  auto unquantized = unquantize(total, row_idx, col_idx, col_size);
+  auto bias_added = add_bias(unquantized, row_idx, col_idx, col_size);
+  auto activated = activate(bias_added, row_idx, col_idx, col_size);
+  write(activated, row_idx, col_idx, col_size);
+}
 } // namespace callbacks
 
 template <class Arch>
@@ -1118,11 +1635,21 @@ void Engine<Arch>::QuantizeU(const float *input, uint8_t *output,
   using batch8 = xsimd::batch<int8_t, Arch>;
 
   xsimd::batch<float, Arch> q(quant_mult);
-  const float *end = input + size;
+  const float *end = input + size / batch8::size * batch8::size;
   for (; input != end; input += batch8::size, output += batch8::size) {
     auto tile = QuantizeTile8::ConsecutiveU(q, input);
     tile.store_aligned(output);
   }
+
+  std::size_t overhang = size & (batch8::size - 1);
+  if (!overhang)
+    return;
+  /* As for Quantize, read the overhang from a copy padded with zeros. */
+  alignas(Arch::alignment()) float padded[batch8::size] = {};
+  std::copy_n(input, overhang, padded);
+  alignas(Arch::alignment()) uint8_t buffer[batch8::size];
+  QuantizeTile8::ConsecutiveU(q, padded).store_aligned(buffer);
+  std::memcpy(output, buffer, overhang);
 }
 
 template <class Arch>
@@ -1142,24 +1669,77 @@ void Engine<Arch>::Quantize(const float *const input, int8_t *const output,
   std::size_t overhang = size & (kBatch - 1);
   if (!overhang)
     return;
-  /* Each does size(xsimd::batch<int8_t, Arch>) / 32 == kBatch / 4 floats at a
-   * time. If we're allowed to read one of them, then we can read the whole
-   * register.
-   */
-  const float *inputs[4];
-  std::size_t i;
-  for (i = 0; i < (overhang + (kBatch / 4) - 1) / (kBatch / 4); ++i) {
-    inputs[i] = &input[fast_end + i * (kBatch / 4)];
+  /* Read the overhang from a copy padded with zeros, so that nothing past
+   * input + size gets read: PrepareA quantizes row by row, and rows other than
+   * the last one are followed by the next row, not by padding. */
+  alignas(Arch::alignment()) float padded[kBatch] = {};
+  std::copy_n(input + fast_end, overhang, padded);
+  alignas(Arch::alignment()) int8_t buffer[kBatch];
+  QuantizeTile8::Consecutive(q, padded).store_aligned(buffer);
+  std::memcpy(output + fast_end, buffer, overhang);
+}
+
+template <class Arch>
+template <class ExecutionEngine>
+float Engine<Arch>::MaxAbsolute(const float *begin, const float *end,
+                                ExecutionEngine &engine) {
+  const size_t size = end - begin;
+  std::vector<float> partials((size + kStatisticsChunk - 1) / kStatisticsChunk);
+  float *partials_addr = partials.data();
+  engine(0, size, kStatisticsChunk, [=](size_t start) {
+    partials_addr[start / kStatisticsChunk] = MaxAbsoluteOf<Arch>(
+        begin + start, std::min(kStatisticsChunk, size - start));
+  });
+  float result = 0.f;
+  for (float partial : partials)
+    result = std::max(result, partial);
+  return result;
+}
+
+template <class Arch>
+template <class ExecutionEngine>
+std::pair<float, float> Engine<Arch>::MinMax(const float *begin,
+                                             const float *end,
+                                             ExecutionEngine &engine) {
+  const size_t size = end - begin;
+  std::vector<std::pair<float, float>> partials(
+      (size + kStatisticsChunk - 1) / kStatisticsChunk);
+  auto *partials_addr = partials.data();
+  engine(0, size, kStatisticsChunk, [=](size_t start) {
+    partials_addr[start / kStatisticsChunk] = MinMaxOf<Arch>(
+        begin + start, std::min(kStatisticsChunk, size - start));
+  });
+  std::pair<float, float> result(std::numeric_limits<float>::infinity(),
+                                 -std::numeric_limits<float>::infinity());
+  for (auto const &partial : partials) {
+    result.first = std::min(result.first, partial.first);
+    result.second = std::max(result.second, partial.second);
   }
-  /* These will be clipped off. */
-  for (; i < 4; ++i) {
-    inputs[i] = &input[fast_end];
+  return result;
+}
+
+template <class Arch>
+template <class ExecutionEngine>
+MeanStd Engine<Arch>::VectorMeanStd(const float *begin, const float *end,
+                                    bool absolute, ExecutionEngine &engine) {
+  const size_t size = end - begin;
+  std::vector<std::pair<double, double>> partials(
+      (size + kStatisticsChunk - 1) / kStatisticsChunk);
+  auto *partials_addr = partials.data();
+  engine(0, size, kStatisticsChunk, [=](size_t start) {
+    partials_addr[start / kStatisticsChunk] = SumsOf<Arch>(
+        begin + start, std::min(kStatisticsChunk, size - start), absolute);
+  });
+  double sum = 0., squares = 0.;
+  for (auto const &partial : partials) {
+    sum += partial.first;
+    squares += partial.second;
   }
-  auto result =
-      QuantizeTile8::Tile(q, inputs[0], inputs[1], inputs[2], inputs[3]);
-  alignas(Arch::alignment()) int8_t buffer[kBatch];
-  result.store_aligned(buffer);
-  std::memcpy(output + (size & ~(kBatch - 1)), buffer, overhang);
+  if (!size)
+    return {0.f, 0.f};
+  const double mean = sum / size;
+  const double variance = std::max(0., squares / size - mean * mean);
+  return {static_cast<float>(mean), static_cast<float>(std::sqrt(variance))};
 }
 
 template <class Arch>
@@ -1174,70 +1754,177 @@ void Engine<Arch>::SelectColumnsB(const int8_t *input, int8_t *output,
 }
 
 template <class Arch>
+template <class ExecutionEngine>
 void Engine<Arch>::PrepareBTransposed(const float *input, int8_t *output,
                                       float quant_mult, size_t cols,
-                                      size_t rows) {
+                                      size_t rows, ExecutionEngine &engine) {
   using batch8 = xsimd::batch<int8_t, Arch>;
   const size_t RegisterElemsInt = batch8::size;
   const size_t kColStride = 8;
 
-  xsimd::batch<float, Arch> q(quant_mult);
-  auto *output_it = reinterpret_cast<batch8 *>(output);
-  size_t r = 0;
-  size_t c = 0;
-  while (r < rows) {
-    for (size_t ri = 0; ri < 8; ++ri)
-      *output_it++ = QuantizeTile8::ConsecutiveWithWrapping(
-          q, input + (r + ri) * cols + c, cols - c, cols, 8);
-    c += RegisterElemsInt;
-    while (c >= cols) {
-      r += kColStride;
-      c -= cols;
-    }
+  /* Rows of the input, i.e. columns of B, are padded with zeros to a whole
+   * number of registers. */
+  const size_t padded_cols = PaddedWidth<Arch>(cols);
+  if (padded_cols != cols) {
+    std::vector<float> padded(rows * padded_cols);
+    for (size_t r = 0; r < rows; ++r)
+      std::copy_n(input + r * cols, cols, padded.data() + r * padded_cols);
+    return PrepareBTransposed(padded.data(), output, quant_mult, padded_cols,
+                              rows, engine);
   }
+
+  /* The last columns of B, if rows is not a multiple of 8, are padded with
+   * zeros to a full block. */
+  const size_t full_rows = rows / kColStride * kColStride;
+  if (full_rows < rows) {
+    std::vector<float> tail(kColStride * cols);
+    std::copy_n(input + full_rows * cols, (rows - full_rows) * cols,
+                tail.data());
+    PrepareBTransposed(tail.data(), output + full_rows * cols, quant_mult,
+                       cols, kColStride, engine);
+    rows = full_rows;
+  }
+
+  /* Each block of 8 columns of B, i.e. rows of the input, is independent. As
+   * rows of the input are now a whole number of registers, they no longer
+   * wrap around. */
+  xsimd::batch<float, Arch> q(quant_mult);
+  engine(0, rows, kColStride, [=](size_t r) {
+    auto *output_it = reinterpret_cast<batch8 *>(output + r * cols);
+    for (size_t c = 0; c < cols; c += RegisterElemsInt)
+      for (size_t ri = 0; ri < 8; ++ri)
+        *output_it++ =
+            QuantizeTile8::Consecutive(q, input + (r + ri) * cols + c);
+  });
 }
 
 template <class Arch>
+void Engine<Arch>::PrepareBTransposedPerColumn(const float *input,
+                                               int8_t *output,
+                                               const float *quant_mults,
+                                               size_t cols, size_t rows) {
+  /* Fold the multipliers into a copy of the input, each of its rows being a
+   * column of B. */
+  std::vector<float> scaled(rows * cols);
+  for (size_t r = 0; r < rows; ++r)
+    for (size_t c = 0; c < cols; ++c)
+      scaled[r * cols + c] = input[r * cols + c] * quant_mults[r];
+  PrepareBTransposed(scaled.data(), output, 1.f, cols, rows);
+}
+
+template <class Arch>
+template <class ExecutionEngine>
 void Engine<Arch>::PrepareBQuantizedTransposed(const int8_t *input,
                                                int8_t *output, size_t cols,
-                                               size_t rows) {
+                                               size_t rows,
+                                               ExecutionEngine &engine) {
   using batch8 = xsimd::batch<int8_t, Arch>;
   const size_t RegisterElems = batch8::size;
   const size_t kColStride = 8;
 
-  auto *output_it = reinterpret_cast<batch8 *>(output);
-  for (size_t r = 0; r < rows; r += kColStride)
+  /* Rows of the input, i.e. columns of B, are padded with zeros to a whole
+   * number of registers. */
+  const size_t padded_cols = PaddedWidth<Arch>(cols);
+  if (padded_cols != cols) {
+    std::vector<batch8> padded(rows * padded_cols / RegisterElems);
+    auto *padded_addr = reinterpret_cast<int8_t *>(padded.data());
+    for (size_t r = 0; r < rows; ++r)
+      std::copy_n(input + r * cols, cols, padded_addr + r * padded_cols);
+    return PrepareBQuantizedTransposed(padded_addr, output, padded_cols, rows,
+                                       engine);
+  }
+
+  /* The last columns of B, if rows is not a multiple of 8, are padded with
+   * zeros to a full block. */
+  const size_t full_rows = rows / kColStride * kColStride;
+  if (full_rows < rows) {
+    std::vector<batch8> tail(kColStride * cols / RegisterElems);
+    std::copy_n(input + full_rows * cols, (rows - full_rows) * cols,
+                reinterpret_cast<int8_t *>(tail.data()));
+    PrepareBQuantizedTransposed(reinterpret_cast<const int8_t *>(tail.data()),
+                                output + full_rows * cols, cols, kColStride,
+                                engine);
+    rows = full_rows;
+  }
+
+  engine(0, rows, kColStride, [=](size_t r) {
+    auto *output_it = reinterpret_cast<batch8 *>(output + r * cols);
     for (size_t c = 0; c < cols; c += RegisterElems)
       for (size_t ri = 0; ri < 8; ++ri)
         *output_it++ =
             *reinterpret_cast<const batch8 *>(input + (r + ri) * cols + c);
+  });
 }
 
 template <class Arch>
-void Engine<Arch>::PrepareBQuantized(const int8_t *input,
-                                     int8_t *output, size_t cols,
-                                     size_t rows) {
+template <class ExecutionEngine>
+void Engine<Arch>::PrepareBQuantized(const int8_t *input, int8_t *output,
+                                     size_t cols, size_t rows,
+                                     ExecutionEngine &engine) {
   using batch8 = xsimd::batch<int8_t, Arch>;
-  const size_t RegisterElems = batch8::size;
   const size_t kColStride = 8;
 
-  auto *output_it = reinterpret_cast<batch8 *>(output);
-  for (size_t r = 0; r < rows; r += kColStride)
-    for (size_t c = 0; c < cols; c += RegisterElems)
-      for (size_t ri = 0; ri < 8; ++ri)
-        *output_it++ = batch8::load_unaligned(input + (c) * rows + r + ri);
+  /* input is B, rows by cols as for PrepareB. Transpose it into a copy padded
+   * the way PrepareBQuantizedTransposed pads its input, which then lays the
+   * copy out as is. */
+  const size_t padded_rows = PaddedWidth<Arch>(rows);
+  const size_t padded_cols = (cols + kColStride - 1) / kColStride * kColStride;
+  std::vector<batch8> transposed(padded_cols * padded_rows / batch8::size);
+  auto *transposed_addr = reinterpret_cast<int8_t *>(transposed.data());
+  for (size_t r = 0; r < rows; ++r)
+    for (size_t c = 0; c < cols; ++c)
+      transposed_addr[c * padded_rows + r] = input[r * cols + c];
+  PrepareBQuantizedTransposed(transposed_addr, output, padded_rows,
+                              padded_cols, engine);
+}
+
+template <class Arch>
+void Engine<Arch>::PrepareBPerColumn(const float *input, int8_t *output,
+                                     const float *quant_mults, size_t rows,
+                                     size_t cols) {
+  /* Fold the multipliers into a copy of the input. */
+  std::vector<float> scaled(rows * cols);
+  for (size_t r = 0; r < rows; ++r)
+    for (size_t c = 0; c < cols; ++c)
+      scaled[r * cols + c] = input[r * cols + c] * quant_mults[c];
+  PrepareB(scaled.data(), output, 1.f, rows, cols);
 }
 
 template <class Arch>
+template <class ExecutionEngine>
 void Engine<Arch>::PrepareB(const float *input, int8_t *output_shadow,
-                            float quant_mult, size_t rows, size_t cols) {
+                            float quant_mult, size_t rows, size_t cols,
+                            ExecutionEngine &engine) {
   using batch8 = xsimd::batch<int8_t, Arch>;
 
   xsimd::batch<float, Arch> q(quant_mult);
   /* Currently all multipliers have a stride of 8 columns.*/
   const size_t kColStride = 8;
-  auto *output = reinterpret_cast<batch8 *>(output_shadow);
-  for (size_t c = 0; c < cols; c += kColStride) {
+
+  /* Rows are padded with zeros to a whole number of registers. */
+  const size_t padded_rows = PaddedWidth<Arch>(rows);
+  if (padded_rows != rows) {
+    std::vector<float> padded(padded_rows * cols);
+    std::copy_n(input, rows * cols, padded.data());
+    return PrepareB(padded.data(), output_shadow, quant_mult, padded_rows,
+                    cols, engine);
+  }
+
+  /* The last columns, if cols is not a multiple of 8, are padded with zeros to
+   * a full block. */
+  const size_t full_cols = cols / kColStride * kColStride;
+  if (full_cols < cols) {
+    std::vector<float> tail(rows * kColStride);
+    for (size_t r = 0; r < rows; ++r)
+      std::copy_n(input + r * cols + full_cols, cols - full_cols,
+                  tail.data() + r * kColStride);
+    PrepareB(tail.data(), output_shadow + full_cols * rows, quant_mult, rows,
+             kColStride, engine);
+  }
+
+  /* Each block of 8 columns is independent, and takes rows * 8 bytes. */
+  engine(0, full_cols, kColStride, [=](size_t c) {
+    auto *output = reinterpret_cast<batch8 *>(output_shadow + c * rows);
     for (size_t r = 0; r < rows; r += sizeof(*output), output += 8) {
       output[0] =
           QuantizeTile8::ForReshape(q, input + cols * (r + 0) + c, cols);
@@ -1270,19 +1957,103 @@ void Engine<Arch>::PrepareB(const float *input, int8_t *output_shadow,
       Transpose16InLane(output[0], output[1], output[2], output[3], output[4],
                         output[5], output[6], output[7]);
     }
+  });
+}
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+template <class Arch>
+void Engine<Arch>::PrepareBAMX(const float *input, int8_t *output,
+                               float quant_mult, size_t rows, size_t cols) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  static_assert(sizeof(batch8) == 64,
+                "AMX tiles are 64 bytes wide, so is the padding of rows");
+
+  /* Rows are padded with zeros to a whole number of registers, i.e. tiles. */
+  const size_t padded_rows = PaddedWidth<Arch>(rows);
+  if (padded_rows != rows) {
+    std::vector<float> padded(padded_rows * cols);
+    std::copy_n(input, rows * cols, padded.data());
+    return PrepareBAMX(padded.data(), output, quant_mult, padded_rows, cols);
+  }
+
+  const size_t tiled_cols = cols / 16 * 16;
+
+  /* Quantize everything first, in natural order, then scatter to tiles. */
+  std::vector<batch8> quantized_storage((rows * cols + batch8::size - 1) /
+                                        batch8::size);
+  auto *quantized = reinterpret_cast<int8_t *>(quantized_storage.data());
+  Quantize(input, quantized, quant_mult, rows * cols);
+
+  for (size_t c = 0; c < tiled_cols; c += 16) {
+    int8_t *block = output + c * rows;
+    for (size_t k = 0; k < rows; k += 4) {
+      /* Row k / 4 of the block, across its tiles. */
+      int8_t *tile_row = block + k * 16;
+      for (size_t n = 0; n < 16; ++n)
+        for (size_t j = 0; j < 4; ++j)
+          tile_row[n * 4 + j] = quantized[(k + j) * cols + c + n];
+    }
+  }
+
+  if (tiled_cols < cols) {
+    std::vector<float> tail(rows * (cols - tiled_cols));
+    for (size_t r = 0; r < rows; ++r)
+      std::copy_n(input + r * cols + tiled_cols, cols - tiled_cols,
+                  tail.data() + r * (cols - tiled_cols));
+    PrepareB(tail.data(), output + tiled_cols * rows, quant_mult, rows,
+             cols - tiled_cols);
   }
 }
+#endif
 
 template <class Arch>
 void Engine<Arch>::PrepareA(const float *input, int8_t *output,
                             float quant_mult, size_t rows, size_t cols) {
-  Quantize(input, output, quant_mult, rows * cols);
+  const size_t padded_cols = PaddedWidth<Arch>(cols);
+  if (padded_cols == cols)
+    return Quantize(input, output, quant_mult, rows * cols);
+  for (size_t r = 0; r < rows; ++r) {
+    Quantize(input + r * cols, output + r * padded_cols, quant_mult, cols);
+    std::fill(output + r * padded_cols + cols, output + (r + 1) * padded_cols,
+              0);
+  }
 }
 
 template <class Arch>
 void Engine<Arch>::Shift::PrepareA(const float *input, uint8_t *output,
                                    float quant_mult, size_t rows, size_t cols) {
-  QuantizeU(input, output, quant_mult, rows * cols);
+  if (PaddedWidth<Arch>(cols) == cols)
+    return QuantizeU(input, output, quant_mult, rows * cols);
+  PrepareAStrided(input, output, quant_mult, rows, cols, cols);
+}
+
+template <class Arch>
+void Engine<Arch>::Shift::PrepareAStrided(const float *input, uint8_t *output,
+                                          float quant_mult, size_t rows,
+                                          size_t cols, size_t lda) {
+  const size_t padded_cols = PaddedWidth<Arch>(cols);
+  for (size_t r = 0; r < rows; ++r) {
+    QuantizeU(input + r * lda, output + r * padded_cols, quant_mult, cols);
+    std::fill(output + r * padded_cols + cols, output + (r + 1) * padded_cols,
+              0);
+  }
+}
+
+template <class Arch>
+void Engine<Arch>::Shift::PrepareADynamic(const float *input, uint8_t *output,
+                                          float *unquant_mults, size_t rows,
+                                          size_t cols) {
+  const size_t padded_cols = PaddedWidth<Arch>(cols);
+  for (size_t r = 0; r < rows; ++r) {
+    /* The row is still in cache when quantized, right after the scan. */
+    const float *row = input + r * cols;
+    const float max_abs = MaxAbsoluteOf<Arch>(row, cols);
+    const float quant_mult = max_abs > 0.f ? 127.f / max_abs : 1.f;
+    unquant_mults[r] = 1.f / quant_mult;
+    QuantizeU(row, output + r * padded_cols, quant_mult, cols);
+    std::fill(output + r * padded_cols + cols, output + (r + 1) * padded_cols,
+              0);
+  }
 }
 
 struct SequentialExecutionEngine {
@@ -1294,59 +2065,691 @@ struct SequentialExecutionEngine {
     }
   }
 
+  template<class F>
+  inline void operator()(size_t RowStart, size_t RowEnd, size_t RowStride,
+                         size_t ColStart, size_t ColEnd, size_t ColStride,
+                         F&& f) {
+    for(size_t j = ColStart; j < ColEnd; j += ColStride) {
+      for(size_t i = RowStart; i < RowEnd; i += RowStride) {
+        f(i, j);
+      }
+    }
+  }
+
+};
+
+template <class Arch>
+void Engine<Arch>::PrepareBTransposed(const float *input, int8_t *output,
+                                      float quant_mult, size_t cols,
+                                      size_t rows) {
+  SequentialExecutionEngine engine;
+  PrepareBTransposed(input, output, quant_mult, cols, rows, engine);
+}
+
+template <class Arch>
+void Engine<Arch>::PrepareBQuantizedTransposed(const int8_t *input,
+                                               int8_t *output, size_t cols,
+                                               size_t rows) {
+  SequentialExecutionEngine engine;
+  PrepareBQuantizedTransposed(input, output, cols, rows, engine);
+}
+
+template <class Arch>
+void Engine<Arch>::PrepareBQuantized(const int8_t *input, int8_t *output,
+                                     size_t cols, size_t rows) {
+  SequentialExecutionEngine engine;
+  PrepareBQuantized(input, output, cols, rows, engine);
+}
+
+template <class Arch>
+void Engine<Arch>::PrepareB(const float *input, int8_t *output_shadow,
+                            float quant_mult, size_t rows, size_t cols) {
+  SequentialExecutionEngine engine;
+  PrepareB(input, output_shadow, quant_mult, rows, cols, engine);
+}
+
+namespace {
+
+/* Number of rows of A processed by each task of Shift::Multiply. Columns of B
+ * are always split in blocks of 8; when there are too few of them to keep many
+ * threads busy, rows of A get split as well, though not below a few rows so
+ * that each task still makes some use of the block of B it loads.
+ */
+inline size_t RowTileSize(size_t A_rows, size_t B_cols) {
+  constexpr size_t kTargetTasks = 128;
+  constexpr size_t kMinRowTile = 4;
+  const size_t col_tasks = std::max<size_t>((B_cols + 7) / 8, 1);
+  const size_t row_tasks = (kTargetTasks + col_tasks - 1) / col_tasks;
+  const size_t row_tile = (A_rows + row_tasks - 1) / row_tasks;
+  return std::max(row_tile, std::min(kMinRowTile, std::max<size_t>(A_rows, 1)));
+}
+
+/* Blocking of Shift::MultiplyBlocked, in the spirit of GotoBLAS: the shared
+ * dimension is cut in slices of k_block registers so that the slice of a block
+ * of 8 columns of B stays in half of L1 while it is reused by every row of A of
+ * a task, and each task walks col_group blocks of B so that its rows of A are
+ * reused from cache across them, fitting in half of L2. With more than one
+ * slice, the totals of the rows of a task are kept on the stack between
+ * slices, hence at most kMaxSlicedRowTile rows per task. */
+struct MultiplyBlocking {
+  static constexpr size_t kMaxSlicedRowTile = 32;
+  size_t k_block;
+  size_t col_group;
+  size_t row_tile;
+};
+
+inline MultiplyBlocking MultiplyBlockingFor(size_t l1_size, size_t l2_size,
+                                            size_t register_bytes,
+                                            size_t simd_width, size_t A_rows,
+                                            size_t B_cols) {
+  constexpr size_t kMinColTasks = 16;
+  MultiplyBlocking blocking;
+  const size_t slice_bytes = 8 * register_bytes;
+  blocking.k_block = std::min(std::max<size_t>(l1_size / 2 / slice_bytes, 1),
+                              std::max<size_t>(simd_width, 1));
+  const size_t col_blocks = std::max<size_t>((B_cols + 7) / 8, 1);
+  const size_t l2_blocks =
+      std::max<size_t>(l2_size / 2 / (blocking.k_block * slice_bytes), 1);
+  blocking.col_group = std::max<size_t>(
+      std::min(l2_blocks, col_blocks / kMinColTasks), 1);
+  const size_t col_tasks =
+      (col_blocks + blocking.col_group - 1) / blocking.col_group;
+  blocking.row_tile = RowTileSize(A_rows, col_tasks * 8);
+  if (simd_width > blocking.k_block) {
+    /* The rows of A of a task should fit in half of L2 too. */
+    const size_t l2_rows =
+        std::max<size_t>(l2_size / 2 / (simd_width * register_bytes), 1);
+    blocking.row_tile = std::min(
+        {blocking.row_tile, l2_rows, MultiplyBlocking::kMaxSlicedRowTile});
+  }
+  return blocking;
+}
+
+/* Number of registers of the shared dimension processed by each task of
+ * Shift::MultiplySplitK. Enough slices to reach a decent number of tasks even
+ * with very few columns of B, but no slice shorter than kMinSliceBytes so that
+ * storing and reducing partial sums stays cheap compared to the dot products.
+ */
+inline size_t SplitKTileSize(size_t simd_width, size_t register_bytes,
+                             size_t B_cols) {
+  constexpr size_t kTargetTasks = 128;
+  constexpr size_t kMinSliceBytes = 512;
+  const size_t col_tasks = std::max<size_t>((B_cols + 7) / 8, 1);
+  const size_t splits = (kTargetTasks + col_tasks - 1) / col_tasks;
+  const size_t k_tile = (simd_width + splits - 1) / splits;
+  const size_t min_k_tile = std::max<size_t>(kMinSliceBytes / register_bytes, 1);
+  return std::max(k_tile, std::min(min_k_tile, std::max<size_t>(simd_width, 1)));
+}
+
+/* Hint the cache about data that is about to be read. */
+inline void Prefetch(const void *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(addr);
+#else
+  (void)addr;
+#endif
+}
+
+/* Prefetch the registers of B used by one step of the shared dimension of a
+ * block of 8 columns, far enough ahead of B0_step to hide memory latency when
+ * B is streamed once, as for a single row of A. Blocks of B being contiguous,
+ * this reaches into the next block at the end of the current one. */
+template <class Arch>
+inline void PrefetchAhead(const xsimd::batch<int8_t, Arch> *B0_step) {
+  constexpr size_t kStepBytes = 8 * sizeof(xsimd::batch<int8_t, Arch>);
+  constexpr size_t kDistance = std::max<size_t>(1024 / kStepBytes, 1);
+  const char *addr = reinterpret_cast<const char *>(B0_step + kDistance * 8);
+  for (size_t offset = 0; offset < kStepBytes; offset += 64)
+    Prefetch(addr + offset);
+}
+
+/* Dot products of one row of A with the 8 columns of a block of B over
+ * registers [k_begin, k_end) of the shared dimension, k_begin < k_end. The
+ * result holds one int32 sum per column, in the arch-specific format expected
+ * by callbacks. A is either unsigned (Shift) or signed. PrefetchB requests
+ * software prefetching of B. */
+template <bool PrefetchB = false, class T, class Arch>
+inline auto MultiplyRow(const xsimd::batch<T, Arch> *A_row,
+                        const xsimd::batch<int8_t, Arch> *B0_col,
+                        size_t k_begin, size_t k_end) {
+  using abatch8 = xsimd::batch<T, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+
+  /* These will be packed 16-bit integers containing sums for each row of B
+     multiplied by the row of A. Iterate over shared (inner) dimension.*/
+  /* Upcast to 32-bit and horizontally add. Seems a bit faster if this is
+   * declared here.*/
+  size_t k = k_begin;
+  abatch8 a = *(A_row + k);
+  batch32 isum0 = maddw(a, *(B0_col + k * 8));
+  batch32 isum1 = maddw(a, *(B0_col + k * 8 + 1));
+  batch32 isum2 = maddw(a, *(B0_col + k * 8 + 2));
+  batch32 isum3 = maddw(a, *(B0_col + k * 8 + 3));
+  batch32 isum4 = maddw(a, *(B0_col + k * 8 + 4));
+  batch32 isum5 = maddw(a, *(B0_col + k * 8 + 5));
+  batch32 isum6 = maddw(a, *(B0_col + k * 8 + 6));
+  batch32 isum7 = maddw(a, *(B0_col + k * 8 + 7));
+  for (k = k_begin + 1; k < k_end; ++k) {
+    if constexpr (PrefetchB)
+      PrefetchAhead(B0_col + k * 8);
+    a = *(A_row + k);
+    /* Multiply 8-bit, horizontally add to packed 16-bit integers.*/
+    /* Upcast to 32-bit and horizontally add.*/
+    isum0 = maddw(a, *(B0_col + k * 8 + 0), isum0);
+    isum1 = maddw(a, *(B0_col + k * 8 + 1), isum1);
+    isum2 = maddw(a, *(B0_col + k * 8 + 2), isum2);
+    isum3 = maddw(a, *(B0_col + k * 8 + 3), isum3);
+    isum4 = maddw(a, *(B0_col + k * 8 + 4), isum4);
+    isum5 = maddw(a, *(B0_col + k * 8 + 5), isum5);
+    isum6 = maddw(a, *(B0_col + k * 8 + 6), isum6);
+    isum7 = maddw(a, *(B0_col + k * 8 + 7), isum7);
+  }
+  /* Reduce sums within 128-bit lanes.*/
+  auto pack0123 = Pack0123(isum0, isum1, isum2, isum3);
+  auto pack4567 = Pack0123(isum4, isum5, isum6, isum7);
+  /*The specific implementation may need to reduce further.*/
+  return PermuteSummer(pack0123, pack4567);
+}
+
+/* Same as MultiplyRow for two rows of A at once, so that each register of B is
+ * loaded once for both rows. This needs 16 accumulators. */
+template <class T, class Arch>
+inline auto MultiplyTwoRows(const xsimd::batch<T, Arch> *A_row0,
+                            const xsimd::batch<T, Arch> *A_row1,
+                            const xsimd::batch<int8_t, Arch> *B0_col,
+                            size_t k_begin, size_t k_end) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  using abatch8 = xsimd::batch<T, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+
+  size_t k = k_begin;
+  abatch8 a0 = *(A_row0 + k);
+  abatch8 a1 = *(A_row1 + k);
+  batch8 b = *(B0_col + k * 8 + 0);
+  batch32 isum0 = maddw(a0, b), jsum0 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 1);
+  batch32 isum1 = maddw(a0, b), jsum1 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 2);
+  batch32 isum2 = maddw(a0, b), jsum2 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 3);
+  batch32 isum3 = maddw(a0, b), jsum3 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 4);
+  batch32 isum4 = maddw(a0, b), jsum4 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 5);
+  batch32 isum5 = maddw(a0, b), jsum5 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 6);
+  batch32 isum6 = maddw(a0, b), jsum6 = maddw(a1, b);
+  b = *(B0_col + k * 8 + 7);
+  batch32 isum7 = maddw(a0, b), jsum7 = maddw(a1, b);
+  for (k = k_begin + 1; k < k_end; ++k) {
+    a0 = *(A_row0 + k);
+    a1 = *(A_row1 + k);
+    b = *(B0_col + k * 8 + 0);
+    isum0 = maddw(a0, b, isum0);
+    jsum0 = maddw(a1, b, jsum0);
+    b = *(B0_col + k * 8 + 1);
+    isum1 = maddw(a0, b, isum1);
+    jsum1 = maddw(a1, b, jsum1);
+    b = *(B0_col + k * 8 + 2);
+    isum2 = maddw(a0, b, isum2);
+    jsum2 = maddw(a1, b, jsum2);
+    b = *(B0_col + k * 8 + 3);
+    isum3 = maddw(a0, b, isum3);
+    jsum3 = maddw(a1, b, jsum3);
+    b = *(B0_col + k * 8 + 4);
+    isum4 = maddw(a0, b, isum4);
+    jsum4 = maddw(a1, b, jsum4);
+    b = *(B0_col + k * 8 + 5);
+    isum5 = maddw(a0, b, isum5);
+    jsum5 = maddw(a1, b, jsum5);
+    b = *(B0_col + k * 8 + 6);
+    isum6 = maddw(a0, b, isum6);
+    jsum6 = maddw(a1, b, jsum6);
+    b = *(B0_col + k * 8 + 7);
+    isum7 = maddw(a0, b, isum7);
+    jsum7 = maddw(a1, b, jsum7);
+  }
+  return std::make_tuple(
+      PermuteSummer(Pack0123(isum0, isum1, isum2, isum3),
+                    Pack0123(isum4, isum5, isum6, isum7)),
+      PermuteSummer(Pack0123(jsum0, jsum1, jsum2, jsum3),
+                    Pack0123(jsum4, jsum5, jsum6, jsum7)));
+}
+
+/* Same as MultiplyRow for two consecutive blocks of 8 columns of B, so that
+ * each register of A is loaded once for 16 columns. Meant for a single row of
+ * A, B being streamed from memory: always prefetches. */
+template <class T, class Arch>
+inline auto MultiplyRowTwoBlocks(const xsimd::batch<T, Arch> *A_row,
+                                 const xsimd::batch<int8_t, Arch> *B0_col,
+                                 const xsimd::batch<int8_t, Arch> *B1_col,
+                                 size_t k_end) {
+  using abatch8 = xsimd::batch<T, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+
+  abatch8 a = *A_row;
+  batch32 isum0 = maddw(a, *(B0_col + 0)), jsum0 = maddw(a, *(B1_col + 0));
+  batch32 isum1 = maddw(a, *(B0_col + 1)), jsum1 = maddw(a, *(B1_col + 1));
+  batch32 isum2 = maddw(a, *(B0_col + 2)), jsum2 = maddw(a, *(B1_col + 2));
+  batch32 isum3 = maddw(a, *(B0_col + 3)), jsum3 = maddw(a, *(B1_col + 3));
+  batch32 isum4 = maddw(a, *(B0_col + 4)), jsum4 = maddw(a, *(B1_col + 4));
+  batch32 isum5 = maddw(a, *(B0_col + 5)), jsum5 = maddw(a, *(B1_col + 5));
+  batch32 isum6 = maddw(a, *(B0_col + 6)), jsum6 = maddw(a, *(B1_col + 6));
+  batch32 isum7 = maddw(a, *(B0_col + 7)), jsum7 = maddw(a, *(B1_col + 7));
+  for (size_t k = 1; k < k_end; ++k) {
+    PrefetchAhead(B0_col + k * 8);
+    PrefetchAhead(B1_col + k * 8);
+    a = *(A_row + k);
+    isum0 = maddw(a, *(B0_col + k * 8 + 0), isum0);
+    jsum0 = maddw(a, *(B1_col + k * 8 + 0), jsum0);
+    isum1 = maddw(a, *(B0_col + k * 8 + 1), isum1);
+    jsum1 = maddw(a, *(B1_col + k * 8 + 1), jsum1);
+    isum2 = maddw(a, *(B0_col + k * 8 + 2), isum2);
+    jsum2 = maddw(a, *(B1_col + k * 8 + 2), jsum2);
+    isum3 = maddw(a, *(B0_col + k * 8 + 3), isum3);
+    jsum3 = maddw(a, *(B1_col + k * 8 + 3), jsum3);
+    isum4 = maddw(a, *(B0_col + k * 8 + 4), isum4);
+    jsum4 = maddw(a, *(B1_col + k * 8 + 4), jsum4);
+    isum5 = maddw(a, *(B0_col + k * 8 + 5), isum5);
+    jsum5 = maddw(a, *(B1_col + k * 8 + 5), jsum5);
+    isum6 = maddw(a, *(B0_col + k * 8 + 6), isum6);
+    jsum6 = maddw(a, *(B1_col + k * 8 + 6), jsum6);
+    isum7 = maddw(a, *(B0_col + k * 8 + 7), isum7);
+    jsum7 = maddw(a, *(B1_col + k * 8 + 7), jsum7);
+  }
+  return std::make_tuple(
+      PermuteSummer(Pack0123(isum0, isum1, isum2, isum3),
+                    Pack0123(isum4, isum5, isum6, isum7)),
+      PermuteSummer(Pack0123(jsum0, jsum1, jsum2, jsum3),
+                    Pack0123(jsum4, jsum5, jsum6, jsum7)));
+}
+
+/* Number of columns of B handled by each task of Shift::MultiplyVector: a
+ * multiple of 16 so that blocks go by pairs, large enough for the task to
+ * amortize its scheduling. */
+inline size_t VectorColTileSize(size_t B_cols) {
+  constexpr size_t kTargetTasks = 64;
+  constexpr size_t kMinColTile = 64;
+  const size_t col_tile = (B_cols + kTargetTasks - 1) / kTargetTasks;
+  return std::max((col_tile + 15) / 16 * 16, kMinColTile);
+}
+
+/* Number of rows of A handled at once by the micro-kernel: two when there are
+ * 32 vector registers to hold 16 accumulators plus operands and temporaries,
+ * one otherwise (16 registers on AVX2 and SSE are already mostly used by a
+ * single row). */
+template <class Arch> constexpr size_t MultiplyRowBlock() {
+  if constexpr (std::is_base_of<xsimd::avx512bw, Arch>::value ||
+                std::is_base_of<xsimd::neon64, Arch>::value)
+    return 2;
+  else
+    return 1;
+}
+
+/* Call f(total, row) for each row of A in [row_begin, row_end), total being
+ * its dot products with a block of 8 columns of B over registers [k_begin,
+ * k_end) of the shared dimension. */
+template <class T, class Arch, class F>
+inline void MultiplyRowRange(const T *A, size_t width, size_t row_begin,
+                             size_t row_end,
+                             const xsimd::batch<int8_t, Arch> *B0_col,
+                             size_t k_begin, size_t k_end, F &&f) {
+  using abatch8 = xsimd::batch<T, Arch>;
+  auto A_row = [A, width](size_t A_rowidx) {
+    return reinterpret_cast<const abatch8 *>(A + A_rowidx * width);
+  };
+
+  size_t A_rowidx = row_begin;
+  if constexpr (MultiplyRowBlock<Arch>() == 2) {
+    for (; A_rowidx + 2 <= row_end; A_rowidx += 2) {
+      auto totals = MultiplyTwoRows(A_row(A_rowidx), A_row(A_rowidx + 1),
+                                    B0_col, k_begin, k_end);
+      f(std::get<0>(totals), A_rowidx);
+      f(std::get<1>(totals), A_rowidx + 1);
+    }
+  }
+  for (; A_rowidx < row_end; ++A_rowidx)
+    f(MultiplyRow(A_row(A_rowidx), B0_col, k_begin, k_end), A_rowidx);
+}
+
+/* Sum two results of MultiplyRow. */
+template <class Arch>
+inline xsimd::batch<int32_t, Arch> AddTotals(xsimd::batch<int32_t, Arch> x,
+                                             xsimd::batch<int32_t, Arch> y) {
+  return x + y;
+}
+
+template <class Arch>
+inline std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>>
+AddTotals(
+    std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>> x,
+    std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>> y) {
+  return {std::get<0>(x) + std::get<0>(y), std::get<1>(x) + std::get<1>(y)};
+}
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+
+/* Whether the OS lets this process use AMX tile data. On Linux, this has to be
+ * requested once per process. */
+inline bool AMXAvailable() {
+  static const bool available = [] {
+#ifdef __linux__
+    constexpr long kArchReqXcompPerm = 0x1023;
+    constexpr long kXFeatureXTileData = 18;
+    return syscall(SYS_arch_prctl, kArchReqXcompPerm, kXFeatureXTileData) == 0;
+#else
+    return true;
+#endif
+  }();
+  return available;
+}
+
+/* Palette 1, with tiles 0 to 7 all 16 rows of 64 bytes: 0-3 accumulate int32
+ * results, 4-5 hold A and 6-7 hold B. */
+struct alignas(64) AMXTileConfig {
+  uint8_t palette_id = 1;
+  uint8_t start_row = 0;
+  uint8_t reserved[14] = {};
+  uint16_t colsb[16] = {64, 64, 64, 64, 64, 64, 64, 64};
+  uint8_t rows[16] = {16, 16, 16, 16, 16, 16, 16, 16};
 };
 
+/* Hand the first nb_rows rows of a 16x16 tile of int32 results, stored row by
+ * row, to callback as two blocks of 8 columns. */
+template <class Total, class Callback>
+inline void AMXEmitTile(const int32_t *C, size_t nb_rows, size_t A_rowidx,
+                        size_t B_colidx, size_t B_cols, Callback &callback) {
+  for (size_t i = 0; i < nb_rows; ++i) {
+    const auto *C_row = reinterpret_cast<const __m256i *>(C + 16 * i);
+    callback(Total(_mm256_load_si256(C_row)), A_rowidx + i, B_colidx, B_cols);
+    callback(Total(_mm256_load_si256(C_row + 1)), A_rowidx + i, B_colidx + 8,
+             B_cols);
+  }
+}
+
+/* Dot products of one row of A with a block of 16 columns in the layout of
+ * PrepareBAMX, through AVX512-VNNI: each 64-byte row of a tile holds 4
+ * consecutive rows of B, so broadcasting 4 bytes of A yields the 16 sums
+ * directly. */
+inline __m512i AMXFallbackRow(const uint8_t *A_row, const int8_t *B_block,
+                              size_t width) {
+  auto a = [A_row](size_t k) {
+    int32_t a4;
+    std::memcpy(&a4, A_row + k, sizeof(a4));
+    return _mm512_set1_epi32(a4);
+  };
+  auto b = [B_block](size_t k) {
+    return _mm512_load_si512(B_block + k * 16);
+  };
+  /* Two accumulators to hide the latency of vpdpbusd. */
+  __m512i sum0 = _mm512_setzero_si512();
+  __m512i sum1 = _mm512_setzero_si512();
+  for (size_t k = 0; k < width; k += 8) {
+    sum0 = _mm512_dpbusd_epi32(sum0, a(k), b(k));
+    sum1 = _mm512_dpbusd_epi32(sum1, a(k + 4), b(k + 4));
+  }
+  return _mm512_add_epi32(sum0, sum1);
+}
+
+/* Multiply rows [A_rowidx0, A_rowidx0 + 16 * row_tiles) of A by columns
+ * [B_colidx0, B_colidx0 + 16 * col_tiles) of B with AMX tiles, row_tiles and
+ * col_tiles being 1 or 2. Tile configuration is per thread, so it is loaded
+ * here, on the thread running the task, and released afterwards. */
+template <class Total, class Callback>
+inline void AMXMultiplyTiles(const uint8_t *A, const int8_t *B, size_t width,
+                             size_t B_cols, size_t A_rowidx0, size_t row_tiles,
+                             size_t B_colidx0, size_t col_tiles,
+                             Callback &callback) {
+  static const AMXTileConfig config;
+  alignas(64) int32_t C[4][16 * 16];
+
+  _tile_loadconfig(&config);
+  const uint8_t *A0 = A + A_rowidx0 * width;
+  const uint8_t *A1 = A0 + 16 * width;
+  const int8_t *B0 = B + B_colidx0 * width;
+  const int8_t *B1 = B0 + 16 * width;
+  if (row_tiles == 2 && col_tiles == 2) {
+    _tile_zero(0);
+    _tile_zero(1);
+    _tile_zero(2);
+    _tile_zero(3);
+    for (size_t k = 0; k < width; k += 64) {
+      _tile_loadd(4, A0 + k, width);
+      _tile_loadd(5, A1 + k, width);
+      _tile_loadd(6, B0 + k * 16, 64);
+      _tile_loadd(7, B1 + k * 16, 64);
+      _tile_dpbusd(0, 4, 6);
+      _tile_dpbusd(1, 4, 7);
+      _tile_dpbusd(2, 5, 6);
+      _tile_dpbusd(3, 5, 7);
+    }
+    _tile_stored(0, C[0], 64);
+    _tile_stored(1, C[1], 64);
+    _tile_stored(2, C[2], 64);
+    _tile_stored(3, C[3], 64);
+    _tile_release();
+    AMXEmitTile<Total>(C[0], 16, A_rowidx0, B_colidx0, B_cols, callback);
+    AMXEmitTile<Total>(C[1], 16, A_rowidx0, B_colidx0 + 16, B_cols, callback);
+    AMXEmitTile<Total>(C[2], 16, A_rowidx0 + 16, B_colidx0, B_cols, callback);
+    AMXEmitTile<Total>(C[3], 16, A_rowidx0 + 16, B_colidx0 + 16, B_cols,
+                       callback);
+    return;
+  }
+  for (size_t row_tile = 0; row_tile < row_tiles; ++row_tile) {
+    for (size_t col_tile = 0; col_tile < col_tiles; ++col_tile) {
+      const uint8_t *A_tile = row_tile ? A1 : A0;
+      const int8_t *B_tile = col_tile ? B1 : B0;
+      _tile_zero(0);
+      for (size_t k = 0; k < width; k += 64) {
+        _tile_loadd(4, A_tile + k, width);
+        _tile_loadd(6, B_tile + k * 16, 64);
+        _tile_dpbusd(0, 4, 6);
+      }
+      _tile_stored(0, C[0], 64);
+      AMXEmitTile<Total>(C[0], 16, A_rowidx0 + 16 * row_tile,
+                         B_colidx0 + 16 * col_tile, B_cols, callback);
+    }
+  }
+  _tile_release();
+}
+
+#endif
+
+/* Shift::MultiplyVector and Multiply for a single row, A being unsigned or
+ * signed. */
+template <class Arch, class T, class Callback, class ExecutionEngine>
+void MultiplyVectorImpl(const T *A, const int8_t *B, size_t width,
+                        size_t B_cols, Callback &callback,
+                        ExecutionEngine &engine) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  using abatch8 = xsimd::batch<T, Arch>;
+
+  /* Rows of A and B are padded to whole registers, see PaddedWidth. */
+  width = PaddedWidth<Arch>(width);
+  const size_t simd_width = width / batch8::size;
+  /* MultiplyRow reads at least one register of A and of each column of B,
+   * and there is nothing to call back anyway, as for MultiplyBlockedImpl. */
+  if (simd_width == 0)
+    return;
+  const size_t col_tile = VectorColTileSize(B_cols);
+  const auto *A_row = reinterpret_cast<const abatch8 *>(A);
+
+  engine(0, B_cols, col_tile, [=, &callback](size_t B0_colidx0) {
+    const size_t B0_colend = std::min(B0_colidx0 + col_tile, B_cols);
+    size_t B0_colidx = B0_colidx0;
+    /* Pairs of blocks need 16 accumulators, only worth it with 32 registers,
+     * as for MultiplyTwoRows. */
+    if constexpr (MultiplyRowBlock<Arch>() == 2) {
+      for (; B0_colidx + 16 <= B0_colend; B0_colidx += 16) {
+        const auto *B0_col =
+            reinterpret_cast<const batch8 *>(B) + simd_width * B0_colidx;
+        auto totals = MultiplyRowTwoBlocks(A_row, B0_col,
+                                           B0_col + simd_width * 8, simd_width);
+        callback(std::get<0>(totals), 0, B0_colidx, B_cols);
+        callback(std::get<1>(totals), 0, B0_colidx + 8, B_cols);
+      }
+    }
+    for (; B0_colidx < B0_colend; B0_colidx += 8) {
+      const auto *B0_col =
+          reinterpret_cast<const batch8 *>(B) + simd_width * B0_colidx;
+      callback(MultiplyRow<true>(A_row, B0_col, 0, simd_width), 0, B0_colidx,
+               B_cols);
+    }
+  });
+}
+
+/* Shift::MultiplyBlocked and Multiply, A being unsigned or signed. */
+template <class Arch, size_t L1CacheSize, size_t L2CacheSize, class T,
+          class Callback, class ExecutionEngine>
+void MultiplyBlockedImpl(const T *A, const int8_t *B, size_t A_rows,
+                         size_t width, size_t lda, size_t B_cols,
+                         Callback &callback, ExecutionEngine &engine) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+  using Total = decltype(PermuteSummer(std::declval<batch32>(),
+                                       std::declval<batch32>()));
+
+  /* Rows of A and B are padded to whole registers, see PaddedWidth. */
+  width = PaddedWidth<Arch>(width);
+  const size_t simd_width = width / batch8::size;
+  const MultiplyBlocking blocking =
+      MultiplyBlockingFor(L1CacheSize, L2CacheSize, sizeof(batch8), simd_width,
+                          A_rows, B_cols);
+  const size_t k_block = blocking.k_block;
+  const size_t row_tile = blocking.row_tile;
+  const size_t col_tile = 8 * blocking.col_group;
+
+  Run2D(engine, 0, A_rows, row_tile, 0, B_cols, col_tile, [=, &callback](size_t A_rowidx0, size_t B0_colidx0) {
+    const size_t A_rowend = std::min(A_rowidx0 + row_tile, A_rows);
+    const size_t B0_colend = std::min(B0_colidx0 + col_tile, B_cols);
+    /* Totals of the slices of the shared dimension already processed, for
+     * each row of the task. Only used when there is more than one slice, the
+     * task then having at most kMaxSlicedRowTile rows. */
+    Total partial[MultiplyBlocking::kMaxSlicedRowTile];
+    for (size_t B0_colidx = B0_colidx0; B0_colidx < B0_colend;
+         B0_colidx += 8) {
+      const auto *B0_col =
+          reinterpret_cast<const batch8 *>(B) + simd_width * B0_colidx;
+      for (size_t k_begin = 0; k_begin < simd_width; k_begin += k_block) {
+        const size_t k_end = std::min(k_begin + k_block, simd_width);
+        MultiplyRowRange(
+            A, lda, A_rowidx0, A_rowend, B0_col, k_begin, k_end,
+            [&](Total const &total, size_t A_rowidx) {
+              const size_t row = A_rowidx - A_rowidx0;
+              if (k_end == simd_width)
+                callback(k_begin == 0 ? total : AddTotals(partial[row], total),
+                         A_rowidx, B0_colidx, B_cols);
+              else if (k_begin == 0)
+                partial[row] = total;
+              else
+                partial[row] = AddTotals(partial[row], total);
+            });
+      }
+    }
+  });
+}
+
+} // namespace
+
+template <class Arch>
+template <class Callback, class ExecutionEngine>
+void Engine<Arch>::Multiply(const int8_t *A, const int8_t *B, size_t A_rows,
+                            size_t width, size_t B_cols, Callback callback,
+                            ExecutionEngine &engine) {
+  if (A_rows == 1)
+    return MultiplyVectorImpl<Arch>(A, B, width, B_cols, callback, engine);
+  MultiplyBlockedImpl<Arch, GEMMOLOGY_L1_CACHE_SIZE, GEMMOLOGY_L2_CACHE_SIZE>(
+      A, B, A_rows, width, PaddedWidth<Arch>(width), B_cols, callback, engine);
+}
+
 template <class Arch>
 template <class Callback, class ExecutionEngine>
 void Engine<Arch>::Shift::Multiply(const uint8_t *A, const int8_t *B,
                                    size_t A_rows, size_t width, size_t B_cols,
                                    Callback callback, ExecutionEngine& engine) {
+  MultiplyStrided(A, B, A_rows, width, B_cols, PaddedWidth<Arch>(width),
+                  callback, engine);
+}
+
+template <class Arch>
+template <class Callback, class ExecutionEngine>
+void Engine<Arch>::Shift::MultiplyStrided(const uint8_t *A, const int8_t *B,
+                                          size_t A_rows, size_t width,
+                                          size_t B_cols, size_t lda,
+                                          Callback callback,
+                                          ExecutionEngine &engine) {
+  if (A_rows == 1)
+    return MultiplyVector(A, B, width, B_cols, callback, engine);
+  MultiplyBlockedImpl<Arch, GEMMOLOGY_L1_CACHE_SIZE, GEMMOLOGY_L2_CACHE_SIZE>(
+      A, B, A_rows, width, lda, B_cols, callback, engine);
+}
+
+template <class Arch>
+template <class Callback, class ExecutionEngine>
+void Engine<Arch>::Shift::MultiplyVector(const uint8_t *A, const int8_t *B,
+                                         size_t width, size_t B_cols,
+                                         Callback callback,
+                                         ExecutionEngine &engine) {
+  MultiplyVectorImpl<Arch>(A, B, width, B_cols, callback, engine);
+}
+
+template <class Arch>
+template <size_t L1CacheSize, size_t L2CacheSize, class Callback,
+          class ExecutionEngine>
+void Engine<Arch>::Shift::MultiplyBlocked(const uint8_t *A, const int8_t *B,
+                                          size_t A_rows, size_t width,
+                                          size_t B_cols, Callback callback,
+                                          ExecutionEngine &engine) {
+  MultiplyBlockedImpl<Arch, L1CacheSize, L2CacheSize>(
+      A, B, A_rows, width, PaddedWidth<Arch>(width), B_cols, callback, engine);
+}
+
+template <class Arch>
+template <class Callback, class ExecutionEngine>
+void Engine<Arch>::Shift::MultiplySplitK(const uint8_t *A, const int8_t *B,
+                                         size_t A_rows, size_t width,
+                                         size_t B_cols, Callback callback,
+                                         ExecutionEngine &engine) {
 
   using batch8 = xsimd::batch<int8_t, Arch>;
-  using ubatch8 = xsimd::batch<uint8_t, Arch>;
   using batch32 = xsimd::batch<int32_t, Arch>;
+  using Total = decltype(PermuteSummer(std::declval<batch32>(),
+                                       std::declval<batch32>()));
 
-  engine(0, B_cols, 8, [A, B, A_rows, width, B_cols, &callback](size_t B0_colidx) {
-    const size_t simd_width = width / batch8::size;
+  /* Rows of A and B are padded to whole registers, see PaddedWidth. */
+  width = PaddedWidth<Arch>(width);
+  const size_t simd_width = width / batch8::size;
+  /* Nothing to split, and nothing to call back either, as for Multiply. */
+  if (simd_width == 0)
+    return;
+  const size_t k_tile = SplitKTileSize(simd_width, sizeof(batch8), B_cols);
+  const size_t splits = (simd_width + k_tile - 1) / k_tile;
+  const size_t col_blocks = (B_cols + 7) / 8;
+
+  /* Partial sums, for each block of 8 columns, slice of the shared dimension
+   * and row of A, in that order. */
+  std::vector<Total> partials(col_blocks * splits * A_rows);
+  Total *partials_addr = partials.data();
+
+  Run2D(engine, 0, simd_width, k_tile, 0, B_cols, 8, [=](size_t k_begin, size_t B0_colidx) {
     const auto *B0_col =
         reinterpret_cast<const batch8 *>(B) + simd_width * B0_colidx;
-    /* Process one row of A at a time.  Doesn't seem to be faster to do multiple
-     * rows of A at once.*/
+    const size_t k_end = std::min(k_begin + k_tile, simd_width);
+    Total *partial =
+        partials_addr + ((B0_colidx / 8) * splits + k_begin / k_tile) * A_rows;
+    MultiplyRowRange(A, width, 0, A_rows, B0_col, k_begin, k_end,
+                     [partial](Total const &total, size_t A_rowidx) {
+                       partial[A_rowidx] = total;
+                     });
+  });
+
+  /* Always reduce slices in the same order, whatever the engine. */
+  engine(0, B_cols, 8, [=, &callback](size_t B0_colidx) {
+    const Total *partial = partials_addr + (B0_colidx / 8) * splits * A_rows;
     for (size_t A_rowidx = 0; A_rowidx < A_rows; ++A_rowidx) {
-      const auto *A_row =
-          reinterpret_cast<const ubatch8 *>(A + A_rowidx * width);
-      /* These will be packed 16-bit integers containing sums for each row of B
-         multiplied by the row of A. Iterate over shared (inner) dimension.*/
-      /* Upcast to 32-bit and horizontally add. Seems a bit faster if this is
-       * declared here.*/
-      size_t k = 0;
-      ubatch8 a = *(A_row + k);
-      batch32 isum0 = maddw(a, *(B0_col + k * 8));
-      batch32 isum1 = maddw(a, *(B0_col + k * 8 + 1));
-      batch32 isum2 = maddw(a, *(B0_col + k * 8 + 2));
-      batch32 isum3 = maddw(a, *(B0_col + k * 8 + 3));
-      batch32 isum4 = maddw(a, *(B0_col + k * 8 + 4));
-      batch32 isum5 = maddw(a, *(B0_col + k * 8 + 5));
-      batch32 isum6 = maddw(a, *(B0_col + k * 8 + 6));
-      batch32 isum7 = maddw(a, *(B0_col + k * 8 + 7));
-      for (k = 1; k < simd_width; ++k) {
-        a = *(A_row + k);
-        /* Multiply 8-bit, horizontally add to packed 16-bit integers.*/
-        /* Upcast to 32-bit and horizontally add.*/
-        isum0 = maddw(a, *(B0_col + k * 8 + 0), isum0);
-        isum1 = maddw(a, *(B0_col + k * 8 + 1), isum1);
-        isum2 = maddw(a, *(B0_col + k * 8 + 2), isum2);
-        isum3 = maddw(a, *(B0_col + k * 8 + 3), isum3);
-        isum4 = maddw(a, *(B0_col + k * 8 + 4), isum4);
-        isum5 = maddw(a, *(B0_col + k * 8 + 5), isum5);
-        isum6 = maddw(a, *(B0_col + k * 8 + 6), isum6);
-        isum7 = maddw(a, *(B0_col + k * 8 + 7), isum7);
-      }
-      /* Reduce sums within 128-bit lanes.*/
-      auto pack0123 = Pack0123(isum0, isum1, isum2, isum3);
-      auto pack4567 = Pack0123(isum4, isum5, isum6, isum7);
-      /*The specific implementation may need to reduce further.*/
-      auto total = PermuteSummer(pack0123, pack4567);
+      Total total = partial[A_rowidx];
+      for (size_t split = 1; split < splits; ++split)
+        total = AddTotals(total, partial[split * A_rows + A_rowidx]);
       callback(total, A_rowidx, B0_colidx, B_cols);
     }
   });
@@ -1357,6 +2760,8 @@ template <class Callback>
 void Engine<Arch>::Shift::PrepareBias(const int8_t *B, size_t width,
                                       size_t B_cols, Callback C) {
   using batch8 = xsimd::batch<int8_t, Arch>;
+  /* Rows of A and B are padded to whole registers, see PaddedWidth. */
+  width = PaddedWidth<Arch>(width);
   const size_t simd_width = width / batch8::size;
   xsimd::batch<uint8_t, Arch> a(1);
   for (size_t j = 0; j < B_cols; j += 8) {
@@ -1400,6 +2805,78 @@ void Engine<Arch>::Shift::PrepareBias(const int8_t *B, size_t width,
   }
 }
 
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+template <class Arch>
+template <class Callback, class ExecutionEngine>
+void Engine<Arch>::Shift::MultiplyAMX(const uint8_t *A, const int8_t *B,
+                                      size_t A_rows, size_t width,
+                                      size_t B_cols, Callback callback,
+                                      ExecutionEngine &engine) {
+  using batch8 = xsimd::batch<int8_t, Arch>;
+  using batch32 = xsimd::batch<int32_t, Arch>;
+  using Total = decltype(PermuteSummer(std::declval<batch32>(),
+                                       std::declval<batch32>()));
+  static_assert(sizeof(batch8) == 64,
+                "AMX tiles are 64 bytes wide, so is the padding of rows");
+
+  /* Rows of A and B are padded to whole registers, see PaddedWidth. */
+  width = PaddedWidth<Arch>(width);
+  const size_t tiled_cols = B_cols / 16 * 16;
+  const bool use_tiles = AMXAvailable();
+
+  /* Tasks of up to 2x2 tiles. */
+  Run2D(engine, 0, A_rows, 32, 0, tiled_cols, 32, [=, &callback](size_t A_rowidx0, size_t B_colidx0) {
+    const size_t A_rowend = std::min(A_rowidx0 + 32, A_rows);
+    const size_t col_tiles = (std::min(B_colidx0 + 32, tiled_cols) - B_colidx0) / 16;
+    size_t A_rowidx = A_rowidx0;
+    if (use_tiles) {
+      const size_t row_tiles = (A_rowend - A_rowidx0) / 16;
+      if (row_tiles)
+        AMXMultiplyTiles<Total>(A, B, width, B_cols, A_rowidx0, row_tiles,
+                                B_colidx0, col_tiles, callback);
+      A_rowidx += 16 * row_tiles;
+    }
+    for (; A_rowidx < A_rowend; ++A_rowidx) {
+      for (size_t col_tile = 0; col_tile < col_tiles; ++col_tile) {
+        const size_t B_colidx = B_colidx0 + 16 * col_tile;
+        alignas(64) int32_t C[16];
+        _mm512_store_si512(C, AMXFallbackRow(A + A_rowidx * width,
+                                             B + B_colidx * width, width));
+        AMXEmitTile<Total>(C, 1, A_rowidx, B_colidx, B_cols, callback);
+      }
+    }
+  });
+
+  /* The last columns, if any, are laid out as by PrepareB. */
+  if (tiled_cols < B_cols) {
+    const size_t simd_width = width / batch8::size;
+    const size_t row_tile = RowTileSize(A_rows, B_cols - tiled_cols);
+    Run2D(engine, 0, A_rows, row_tile, tiled_cols, B_cols, 8, [=, &callback](size_t A_rowidx0, size_t B0_colidx) {
+      const auto *B0_col = reinterpret_cast<const batch8 *>(B + B0_colidx * width);
+      MultiplyRowRange(A, width, A_rowidx0,
+                       std::min(A_rowidx0 + row_tile, A_rows), B0_col, 0,
+                       simd_width, [&](Total const &total, size_t A_rowidx) {
+                         callback(total, A_rowidx, B0_colidx, B_cols);
+                       });
+    });
+  }
+}
+
+template <class Arch>
+template <class Callback>
+void Engine<Arch>::Shift::PrepareBiasAMX(const int8_t *B, size_t width,
+                                         size_t B_cols, Callback C) {
+  using ubatch8 = xsimd::batch<uint8_t, Arch>;
+  /* Column sums, as a product with a row of ones. */
+  std::vector<ubatch8> ones(PaddedWidth<Arch>(width) / ubatch8::size,
+                            ubatch8(1));
+  SequentialExecutionEngine engine;
+  MultiplyAMX(reinterpret_cast<const uint8_t *>(ones.data()), B, 1, width,
+              B_cols, C, engine);
+}
+#endif
+
 } // namespace gemmology
 
 #endif
@@ -0,0 +1,95 @@
+/* Kernels of gemmology_dispatch.h for gemmology::default_arch, i.e. for the
+ * architecture this file is compiled for. See gemmology_dispatch.h. */
+
+#include "gemmology_dispatch.h"
+#include "gemmology.h"
+
+namespace gemmology {
+namespace dispatch {
+
+namespace {
+
+/* default_arch under a name private to this file. All the templates below are
+ * instantiated for it, with the flags of this file: instantiated for
+ * default_arch itself, those shared with the objects built for the other
+ * architectures, such as the callbacks called with 256-bit totals by both the
+ * AVX2 and AVX512 kernels, would be weak symbols the linker picks any copy
+ * of. */
+struct local_arch : default_arch {
+#ifdef __AVX512BW__
+  struct half_arch : xsimd::avx2 {};
+#endif
+};
+
+} // namespace
+} // namespace dispatch
+} // namespace gemmology
+
+namespace xsimd {
+namespace types {
+XSIMD_DECLARE_SIMD_REGISTER_ALIAS(gemmology::dispatch::local_arch,
+                                  gemmology::default_arch);
+#ifdef __AVX512BW__
+XSIMD_DECLARE_SIMD_REGISTER_ALIAS(gemmology::dispatch::local_arch::half_arch,
+                                  xsimd::avx2);
+#endif
+} // namespace types
+} // namespace xsimd
+
+namespace gemmology {
+namespace dispatch {
+
+namespace {
+
+template <class Arch> struct Entries {
+  template <class Callback>
+  static void Multiply(const uint8_t *A, const int8_t *B, size_t A_rows,
+                       size_t width, size_t B_cols, Callback callback) {
+    SequentialExecutionEngine engine;
+    Engine<Arch>::Shift::Multiply(A, B, A_rows, width, B_cols, callback,
+                                  engine);
+  }
+
+  template <class Callback>
+  static void MultiplyWithEngine(const uint8_t *A, const int8_t *B,
+                                 size_t A_rows, size_t width, size_t B_cols,
+                                 Callback callback, ExecutionEngineRef engine) {
+    Engine<Arch>::Shift::Multiply(A, B, A_rows, width, B_cols, callback,
+                                  engine);
+  }
+
+  template <class Callback>
+  static void PrepareBias(const int8_t *B, size_t width, size_t B_cols,
+                          Callback callback) {
+    Engine<Arch>::Shift::PrepareBias(B, width, B_cols, callback);
+  }
+};
+
+} // namespace
+
+template <class Arch> const Kernels &KernelsFor() {
+  using E = Entries<local_arch>;
+  static const Kernels kernels = {
+      Arch::name(),
+      &Engine<local_arch>::Quantize,
+      &Engine<local_arch>::QuantizeU,
+      &Engine<local_arch>::PrepareB,
+      &Engine<local_arch>::Shift::PrepareA,
+      {&E::template Multiply<callbacks::Write>,
+       &E::template Multiply<callbacks::UnquantizeAndWrite>,
+       &E::template Multiply<callbacks::UnquantizeAndAddBiasAndWrite>},
+      {&E::template MultiplyWithEngine<callbacks::Write>,
+       &E::template MultiplyWithEngine<callbacks::UnquantizeAndWrite>,
+       &E::template MultiplyWithEngine<
+           callbacks::UnquantizeAndAddBiasAndWrite>},
+      {&E::template PrepareBias<callbacks::Write>,
+       &E::template PrepareBias<callbacks::UnquantizeAndWrite>,
+       &E::template PrepareBias<callbacks::UnquantizeAndAddBiasAndWrite>},
+  };
+  return kernels;
+}
+
+template const Kernels &KernelsFor<default_arch>();
+
+} // namespace dispatch
+} // namespace gemmology
@@ -0,0 +1,243 @@
+/***************************************************************
+ *                                       _                     *
+ *                                      | |                    *
+ *   __ _  ___ _ __ ___  _ __ ___   ___ | | ___   __ _ _   _   *
+ *  / _` |/ _ \ '_ ` _ \| '_ ` _ \ / _ \| |/ _ \ / _` | | | |  *
+ * | (_| |  __/ | | | | | | | | | | (_) | | (_) | (_| | |_| |  *
+ *  \__, |\___|_| |_| |_|_| |_| |_|\___/|_|\___/ \__, |\__, |  *
+ *   __/ |                                        __/ | __/ |  *
+ *  |___/                                        |___/ |___/   *
+ *                                                             *
+ *                                                 version 0.1 *
+ ***************************************************************/
+
+#ifndef GEMMOLOGY_DISPATCH_H
+#define GEMMOLOGY_DISPATCH_H
+
+/* Runtime dispatch over Engine<Arch>, for a single binary running on x86 hosts
+ * of different generations.
+ *
+ * gemmology_dispatch.cpp is compiled once per architecture, each time with the
+ * matching flags (-msse2, -mssse3, -msse4.2, -mavx2, -mavxvnni, -mavx512bw
+ * -mavx512f -mavx512dq -mavx512cd, and the same plus -mavx512vnni), and all the
+ * resulting objects are linked together. The best architecture supported by
+ * the CPU is picked on first use and its kernels are kept for the rest of the
+ * process, so each call costs one indirect call.
+ *
+ * Each object instantiates the library for an architecture private to it, so
+ * that no code built with the flags of one gets picked by the linker for
+ * another (see check.dispatch in test/Makefile).
+ *
+ * PrepareB output is only valid for the Multiply of the same architecture,
+ * which is guaranteed as long as both go through this header.
+ */
+
+#include "gemmology_fwd.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+
+namespace gemmology {
+namespace dispatch {
+
+/* Reference to any execution engine, so that the kernels of every
+ * architecture can run on the engine of the caller. Only the 1D protocol goes
+ * through it, 2D iteration spaces being flattened, at the cost of one
+ * indirect call per iteration. The engine must outlive the reference. */
+class ExecutionEngineRef {
+  using Body = void (*)(void *f, size_t i);
+
+public:
+  template <class ExecutionEngine,
+            class = std::enable_if_t<!std::is_same<
+                std::decay_t<ExecutionEngine>, ExecutionEngineRef>::value>>
+  ExecutionEngineRef(ExecutionEngine &engine)
+      : Target(std::addressof(engine)), Runner(&Run<ExecutionEngine>) {}
+
+  template <class F>
+  void operator()(size_t Start, size_t End, size_t Stride, F &&f) {
+    Runner(Target, Start, End, Stride, (void *)std::addressof(f),
+           [](void *f, size_t i) {
+             (*static_cast<std::remove_reference_t<F> *>(f))(i);
+           });
+  }
+
+private:
+  template <class ExecutionEngine>
+  static void Run(void *engine, size_t Start, size_t End, size_t Stride,
+                  void *f, Body body) {
+    (*static_cast<ExecutionEngine *>(engine))(
+        Start, End, Stride, [=](size_t i) { body(f, i); });
+  }
+
+  void *Target;
+  void (*Runner)(void *engine, size_t Start, size_t End, size_t Stride,
+                 void *f, Body body);
+};
+
+/* The entry points of Engine<Arch>, for one architecture. Multiply and
+ * PrepareBias run sequentially and accept the callbacks below, while
+ * MultiplyWithEngine runs Multiply on the given engine. */
+struct Kernels {
+  template <class Callback>
+  using MultiplyFn = void (*)(const uint8_t *A, const int8_t *B, size_t A_rows,
+                              size_t width, size_t B_cols, Callback callback);
+  template <class Callback>
+  using MultiplyWithEngineFn = void (*)(const uint8_t *A, const int8_t *B,
+                                        size_t A_rows, size_t width,
+                                        size_t B_cols, Callback callback,
+                                        ExecutionEngineRef engine);
+  template <class Callback>
+  using PrepareBiasFn = void (*)(const int8_t *B, size_t width, size_t B_cols,
+                                 Callback callback);
+
+  const char *name;
+  void (*Quantize)(const float *input, int8_t *output, float quant_mult,
+                   size_t size);
+  void (*QuantizeU)(const float *input, uint8_t *output, float quant_mult,
+                    size_t size);
+  void (*PrepareB)(const float *input, int8_t *output, float quant_mult,
+                   size_t rows, size_t cols);
+  void (*PrepareA)(const float *input, uint8_t *output, float quant_mult,
+                   size_t rows, size_t cols);
+  std::tuple<MultiplyFn<callbacks::Write>,
+             MultiplyFn<callbacks::UnquantizeAndWrite>,
+             MultiplyFn<callbacks::UnquantizeAndAddBiasAndWrite>>
+      Multiply;
+  std::tuple<MultiplyWithEngineFn<callbacks::Write>,
+             MultiplyWithEngineFn<callbacks::UnquantizeAndWrite>,
+             MultiplyWithEngineFn<callbacks::UnquantizeAndAddBiasAndWrite>>
+      MultiplyWithEngine;
+  std::tuple<PrepareBiasFn<callbacks::Write>,
+             PrepareBiasFn<callbacks::UnquantizeAndWrite>,
+             PrepareBiasFn<callbacks::UnquantizeAndAddBiasAndWrite>>
+      PrepareBias;
+};
+
+// Defined in gemmology_dispatch.cpp, built with the flags of Arch.
+template <class Arch> const Kernels &KernelsFor();
+
+// Whether the CPU running this process supports Arch.
+template <class Arch> bool Supported();
+
+#if defined(__x86_64__) || defined(__i386__)
+extern template const Kernels &KernelsFor<xsimd::sse2>();
+extern template const Kernels &KernelsFor<xsimd::ssse3>();
+extern template const Kernels &KernelsFor<xsimd::sse4_2>();
+extern template const Kernels &KernelsFor<xsimd::avx2>();
+extern template const Kernels &KernelsFor<xsimd::avxvnni>();
+extern template const Kernels &KernelsFor<xsimd::avx512bw>();
+extern template const Kernels &KernelsFor<xsimd::avx512vnni<xsimd::avx512bw>>();
+
+template <> inline bool Supported<xsimd::sse2>() {
+  return __builtin_cpu_supports("sse2");
+}
+template <> inline bool Supported<xsimd::ssse3>() {
+  return __builtin_cpu_supports("ssse3");
+}
+template <> inline bool Supported<xsimd::sse4_2>() {
+  return __builtin_cpu_supports("sse4.2");
+}
+template <> inline bool Supported<xsimd::avx2>() {
+  return __builtin_cpu_supports("avx2");
+}
+template <> inline bool Supported<xsimd::avxvnni>() {
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("avxvnni");
+}
+template <> inline bool Supported<xsimd::avx512bw>() {
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512cd") &&
+         __builtin_cpu_supports("avx512dq") &&
+         __builtin_cpu_supports("avx512bw");
+}
+template <> inline bool Supported<xsimd::avx512vnni<xsimd::avx512bw>>() {
+  return Supported<xsimd::avx512bw>() && __builtin_cpu_supports("avx512vnni");
+}
+
+/* The kernels of the best architecture the CPU supports, cpuid being queried
+ * on every call. */
+inline const Kernels &Select() {
+  __builtin_cpu_init();
+  if (Supported<xsimd::avx512vnni<xsimd::avx512bw>>())
+    return KernelsFor<xsimd::avx512vnni<xsimd::avx512bw>>();
+  if (Supported<xsimd::avx512bw>())
+    return KernelsFor<xsimd::avx512bw>();
+  if (Supported<xsimd::avxvnni>())
+    return KernelsFor<xsimd::avxvnni>();
+  if (Supported<xsimd::avx2>())
+    return KernelsFor<xsimd::avx2>();
+  if (Supported<xsimd::sse4_2>())
+    return KernelsFor<xsimd::sse4_2>();
+  if (Supported<xsimd::ssse3>())
+    return KernelsFor<xsimd::ssse3>();
+  return KernelsFor<xsimd::sse2>();
+}
+#else
+inline const Kernels &Select() { return KernelsFor<default_arch>(); }
+#endif
+
+// Same as Select, but only queries cpuid once.
+inline const Kernels &Selected() {
+  static const Kernels &kernels = Select();
+  return kernels;
+}
+
+//
+// Same API as the top-level wrappers, through the selected kernels.
+//
+
+inline void Quantize(const float *input, int8_t *output, float quant_mult,
+                     size_t size) {
+  return Selected().Quantize(input, output, quant_mult, size);
+}
+
+inline void QuantizeU(const float *input, uint8_t *output, float quant_mult,
+                      size_t size) {
+  return Selected().QuantizeU(input, output, quant_mult, size);
+}
+
+inline void PrepareB(const float *input, int8_t *output, float quant_mult,
+                     size_t rows, size_t cols) {
+  return Selected().PrepareB(input, output, quant_mult, rows, cols);
+}
+
+namespace Shift {
+
+inline void PrepareA(const float *input, uint8_t *output, float quant_mult,
+                     size_t rows, size_t cols) {
+  return Selected().PrepareA(input, output, quant_mult, rows, cols);
+}
+
+template <class Callback>
+inline void Multiply(const uint8_t *A, const int8_t *B, size_t A_rows,
+                     size_t width, size_t B_cols, Callback C) {
+  return std::get<Kernels::MultiplyFn<Callback>>(Selected().Multiply)(
+      A, B, A_rows, width, B_cols, C);
+}
+
+// Same as above, on engine, e.g. a StdThreadExecutionEngine.
+template <class Callback, class ExecutionEngine>
+inline void Multiply(const uint8_t *A, const int8_t *B, size_t A_rows,
+                     size_t width, size_t B_cols, Callback C,
+                     ExecutionEngine &&engine) {
+  return std::get<Kernels::MultiplyWithEngineFn<Callback>>(
+      Selected().MultiplyWithEngine)(A, B, A_rows, width, B_cols, C,
+                                     ExecutionEngineRef(engine));
+}
+
+template <class Callback>
+inline void PrepareBias(const int8_t *B, size_t width, size_t B_cols,
+                        Callback C) {
+  return std::get<Kernels::PrepareBiasFn<Callback>>(Selected().PrepareBias)(
+      B, width, B_cols, C);
+}
+
+} // namespace Shift
+
+} // namespace dispatch
+} // namespace gemmology
+
+#endif
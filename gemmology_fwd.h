@@ -14,57 +14,394 @@
 #ifndef GEMMOLOGY_FWD_H
 #define GEMMOLOGY_FWD_H
 
+#include <algorithm>
 #include <cstdint>
 #include <cstring>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <xsimd/xsimd.hpp>
 
 #ifdef GEMMOLOGY_WITH_STD_THREAD
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <thread>
 #include <vector>
 #endif
 
+/* Data cache sizes, in bytes, used to block Shift::Multiply over the shared
+ * dimension and the columns of B. Can be overridden at build time. */
+#ifndef GEMMOLOGY_L1_CACHE_SIZE
+#define GEMMOLOGY_L1_CACHE_SIZE (32 * 1024)
+#endif
+#ifndef GEMMOLOGY_L2_CACHE_SIZE
+#define GEMMOLOGY_L2_CACHE_SIZE (1024 * 1024)
+#endif
+
+namespace gemmology {
+
+/* Architectures not known to xsimd, for the dot product instructions they add.
+ * They behave as their base for everything else. */
+#ifdef __AVXVNNIINT8__
+/* AVX-VNNI-INT8: vpdpbssd, signed by signed 8-bit dot products. */
+struct avxvnniint8 : xsimd::avxvnni {
+  static constexpr bool supported() noexcept { return true; }
+  static constexpr bool available() noexcept { return true; }
+  static constexpr char const *name() noexcept { return "avxvnniint8"; }
+};
+#endif
+
+#ifdef __AVX10_2__
+/* AVX10.2: 512-bit vpdpbssd on top of AVX512-VNNI. */
+struct avx10_2 : xsimd::avx512vnni<xsimd::avx512bw> {
+  static constexpr bool supported() noexcept { return true; }
+  static constexpr bool available() noexcept { return true; }
+  static constexpr char const *name() noexcept { return "avx10.2"; }
+};
+#endif
+
+/* Default architecture of the top-level wrappers: xsimd's, unless one of the
+ * above is available and at least as wide. */
+#if defined(__AVX10_2__)
+using default_arch = avx10_2;
+#elif defined(__AVXVNNIINT8__) && !defined(__AVX512BW__)
+using default_arch = avxvnniint8;
+#else
+using default_arch = xsimd::default_arch;
+#endif
+
+} // namespace gemmology
+
+namespace xsimd {
+namespace types {
+#ifdef __AVXVNNIINT8__
+XSIMD_DECLARE_SIMD_REGISTER_ALIAS(gemmology::avxvnniint8, avxvnni);
+#endif
+#ifdef __AVX10_2__
+XSIMD_DECLARE_SIMD_REGISTER_ALIAS(gemmology::avx10_2, avx512vnni<avx512bw>);
+#endif
+} // namespace types
+} // namespace xsimd
+
 namespace gemmology {
 
+/* Execution engines run a loop body f either over a 1D range,
+ *
+ *   engine(Start, End, Stride, f) calls f(i) for i in [Start, End)
+ *
+ * or over a 2D one,
+ *
+ *   engine(RowStart, RowEnd, RowStride, ColStart, ColEnd, ColStride, f)
+ *   calls f(row, col) for each row in [RowStart, RowEnd) and col in
+ *   [ColStart, ColEnd).
+ *
+ * The 2D overload is optional: library code goes through Run2D, which falls
+ * back to Flatten2D for engines only implementing the 1D one.
+ */
 struct SequentialExecutionEngine;
 
+/* Run a 2D iteration space through the 1D protocol of engine. Rows vary
+ * fastest so that consecutive iterations share the same column. */
+template<class ExecutionEngine, class F>
+inline void Flatten2D(ExecutionEngine& engine, size_t RowStart, size_t RowEnd,
+                      size_t RowStride, size_t ColStart, size_t ColEnd,
+                      size_t ColStride, F&& f) {
+  const size_t NbRow = RowStart < RowEnd ? (RowEnd - RowStart + RowStride - 1) / RowStride : 0;
+  const size_t NbCol = ColStart < ColEnd ? (ColEnd - ColStart + ColStride - 1) / ColStride : 0;
+  engine(0, NbRow * NbCol, 1, [=, &f](size_t i) {
+    f(RowStart + (i % NbRow) * RowStride, ColStart + (i / NbRow) * ColStride);
+  });
+}
+
+/* Run a 2D iteration space through the 2D overload of engine if it has one,
+ * through Flatten2D otherwise. */
+template<class ExecutionEngine, class F>
+inline void Run2D(ExecutionEngine& engine, size_t RowStart, size_t RowEnd,
+                  size_t RowStride, size_t ColStart, size_t ColEnd,
+                  size_t ColStride, F&& f) {
+  if constexpr (std::is_invocable<ExecutionEngine&, size_t, size_t, size_t,
+                                  size_t, size_t, size_t, F&>::value)
+    engine(RowStart, RowEnd, RowStride, ColStart, ColEnd, ColStride, f);
+  else
+    Flatten2D(engine, RowStart, RowEnd, RowStride, ColStart, ColEnd, ColStride, f);
+}
+
 #ifdef GEMMOLOGY_WITH_STD_THREAD
+
+/* Long-lived pool of PoolSize - 1 worker threads, the calling thread acting as
+ * the last worker. Work is published by bumping a generation counter: idle
+ * workers first spin on it, then go to sleep on a condition variable. A pool
+ * is meant to be driven by one thread at a time.
+ */
+class StdThreadPool {
+
+  public:
+    StdThreadPool(size_t PoolSize) : NbWorkers(PoolSize ? PoolSize - 1 : 0) {
+      Workers.reserve(NbWorkers);
+      for(size_t threadID = 0; threadID < NbWorkers; ++threadID) {
+        Workers.emplace_back([this, threadID]() { WorkerLoop(threadID); });
+      }
+    }
+
+    ~StdThreadPool() {
+      Stop = true;
+      Publish();
+      for(auto& Worker : Workers) {
+        Worker.join();
+      }
+    }
+
+    StdThreadPool(StdThreadPool const&) = delete;
+    StdThreadPool& operator=(StdThreadPool const&) = delete;
+
+    size_t size() const { return NbWorkers + 1; }
+
+    /* Call f(threadID) once on each thread of the pool, threadID ranging over
+     * [0, size()), and return once all calls are done. The calling thread
+     * takes size() - 1. */
+    template<class F>
+    void Run(F& f) {
+      Task = [](void* Ctx, size_t threadID) { (*static_cast<F*>(Ctx))(threadID); };
+      TaskCtx = static_cast<void*>(&f);
+      Pending.store(NbWorkers, std::memory_order_relaxed);
+      Publish();
+      f(NbWorkers);
+      WaitForWorkers();
+    }
+
+  private:
+    static constexpr size_t SpinCount = 2048;
+
+    static inline void Pause() {
+#if defined(__SSE2__)
+      _mm_pause();
+#elif defined(__aarch64__)
+      __asm__ __volatile__("yield");
+#endif
+    }
+
+    void Publish() {
+      Generation.fetch_add(1);
+      /* Pairs with the increment of Sleepers in WaitForWork: either the
+       * worker sees the new generation before sleeping, or we see it asleep. */
+      if(Sleepers.load()) {
+        std::lock_guard<std::mutex> Lock(Mutex);
+        WakeUp.notify_all();
+      }
+    }
+
+    size_t WaitForWork(size_t Seen) {
+      for(size_t Spin = 0; Spin < SpinCount; ++Spin) {
+        size_t Current = Generation.load(std::memory_order_acquire);
+        if(Current != Seen)
+          return Current;
+        Pause();
+      }
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Sleepers.fetch_add(1);
+      WakeUp.wait(Lock, [this, Seen]() { return Generation.load() != Seen; });
+      Sleepers.fetch_sub(1);
+      return Generation.load();
+    }
+
+    void WaitForWorkers() {
+      for(size_t Spin = 0; Spin < SpinCount; ++Spin) {
+        if(!Pending.load(std::memory_order_acquire))
+          return;
+        Pause();
+      }
+      std::unique_lock<std::mutex> Lock(Mutex);
+      Done.wait(Lock, [this]() { return !Pending.load(std::memory_order_acquire); });
+    }
+
+    void WorkerLoop(size_t threadID) {
+      size_t Seen = 0;
+      while(true) {
+        Seen = WaitForWork(Seen);
+        if(Stop)
+          return;
+        Task(TaskCtx, threadID);
+        if(Pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          std::lock_guard<std::mutex> Lock(Mutex);
+          Done.notify_one();
+        }
+      }
+    }
+
+    const size_t NbWorkers;
+    std::vector<std::thread> Workers;
+
+    void (*Task)(void*, size_t) = nullptr;
+    void* TaskCtx = nullptr;
+    bool Stop = false;
+
+    std::atomic<size_t> Generation{0};
+    std::atomic<size_t> Pending{0};
+    std::atomic<size_t> Sleepers{0};
+    std::mutex Mutex;
+    std::condition_variable WakeUp;
+    std::condition_variable Done;
+};
+
 struct StdThreadExecutionEngine {
 
-  StdThreadExecutionEngine(size_t PoolSize) : MaxPoolSize(PoolSize) {
-    Pool.reserve(PoolSize - 1);
+  StdThreadExecutionEngine(size_t PoolSize) : Pool(PoolSize) {
   }
 
   template<class F>
   inline void operator()(size_t Start, size_t End, size_t Stride, F&& f) {
-    const size_t NbIter = (End - Start) / Stride;
-    const size_t NbThread = std::min(NbIter, MaxPoolSize);
+    const size_t NbIter = Start < End ? (End - Start) / Stride : 0;
+    const size_t NbThread = std::min(NbIter, Pool.size());
+
+    // Not worth waking up the pool.
+    if(NbThread <= 1) {
+      for(size_t i = Start; i < End; i += Stride) {
+        f(i);
+      }
+      return;
+    }
+
     const size_t Chunk = (NbIter / NbThread) * Stride;
+    const size_t CallerID = Pool.size() - 1;
 
-    size_t Curr = Start, Next = Start;
+    auto Worker = [=, &f](size_t threadID) {
+      size_t Curr, Next;
+      if(threadID == CallerID) {
+        Curr = Start + (NbThread - 1) * Chunk;
+        Next = End;
+      }
+      else if(threadID < NbThread - 1) {
+        Curr = Start + threadID * Chunk;
+        Next = Curr + Chunk;
+      }
+      else {
+        return;
+      }
+      for(size_t i = Curr; i < Next; i += Stride) {
+        f(i);
+      }
+    };
+    Pool.Run(Worker);
+  }
 
-    for(size_t threadID = 0; threadID < NbThread - 1; ++threadID) {
-      Next += Chunk;
-      Pool.emplace_back([=]() {
-        for(size_t i = Curr; i < Next; i += Stride) {
-          f(i);
-        };
-      });
-      Curr = Next;
+  template<class F>
+  inline void operator()(size_t RowStart, size_t RowEnd, size_t RowStride,
+                         size_t ColStart, size_t ColEnd, size_t ColStride,
+                         F&& f) {
+    Flatten2D(*this, RowStart, RowEnd, RowStride, ColStart, ColEnd, ColStride, f);
+  }
+
+  private:
+    StdThreadPool Pool;
+
+};
+
+/* Runs on the same kind of pool as StdThreadExecutionEngine, but each thread
+ * owns a queue of iterations and, once it is empty, steals half of the
+ * iterations left in the queue of a randomly picked thread. This keeps all
+ * threads busy when the iteration count does not divide evenly or when a
+ * thread gets preempted.
+ */
+struct StdThreadWorkStealingExecutionEngine {
+
+  StdThreadWorkStealingExecutionEngine(size_t PoolSize)
+      : Pool(PoolSize), Queues(Pool.size()) {}
+
+  template<class F>
+  inline void operator()(size_t Start, size_t End, size_t Stride, F&& f) {
+    const size_t NbIter = Start < End ? (End - Start + Stride - 1) / Stride : 0;
+    const size_t NbThread = std::min(NbIter, Pool.size());
+
+    // Not worth waking up the pool.
+    if(NbThread <= 1) {
+      for(size_t i = Start; i < End; i += Stride) {
+        f(i);
+      }
+      return;
     }
 
-    for(size_t i = Next; i < End; i += Stride) {
-      f(i);
-    };
-    for(size_t threadID = 0; threadID < Pool.size(); ++threadID) {
-      Pool[threadID].join();
+    for(size_t threadID = 0; threadID < Queues.size(); ++threadID) {
+      const size_t Begin = std::min(threadID, NbThread) * NbIter / NbThread;
+      const size_t Next = std::min(threadID + 1, NbThread) * NbIter / NbThread;
+      Queues[threadID].Range.store(Pack(Begin, Next), std::memory_order_relaxed);
     }
-    Pool.clear();
+
+    auto Worker = [=, &f](size_t threadID) {
+      uint32_t Seed = static_cast<uint32_t>(threadID) * 0x9E3779B9u + 1;
+      size_t Iter;
+      do {
+        while(Pop(threadID, Iter)) {
+          f(Start + Iter * Stride);
+        }
+      } while(Steal(threadID, Seed));
+    };
+    Pool.Run(Worker);
+  }
+
+  template<class F>
+  inline void operator()(size_t RowStart, size_t RowEnd, size_t RowStride,
+                         size_t ColStart, size_t ColEnd, size_t ColStride,
+                         F&& f) {
+    Flatten2D(*this, RowStart, RowEnd, RowStride, ColStart, ColEnd, ColStride, f);
   }
 
   private:
-    const size_t MaxPoolSize;
-    std::vector<std::thread> Pool;
+    /* A queue is a range of iteration indices [Begin, End) packed in a single
+     * word, so that the owner popping from the front and thieves cutting from
+     * the back can all update it with a compare-and-swap. */
+    struct alignas(64) Queue {
+      std::atomic<uint64_t> Range{0};
+    };
+
+    static uint64_t Pack(size_t Begin, size_t End) {
+      return (static_cast<uint64_t>(Begin) << 32) | static_cast<uint64_t>(End);
+    }
+    static size_t Begin(uint64_t Range) { return Range >> 32; }
+    static size_t End(uint64_t Range) { return Range & 0xFFFFFFFFu; }
+
+    bool Pop(size_t threadID, size_t& Iter) {
+      auto& Range = Queues[threadID].Range;
+      uint64_t Current = Range.load(std::memory_order_acquire);
+      while(Begin(Current) < End(Current)) {
+        if(Range.compare_exchange_weak(Current, Pack(Begin(Current) + 1, End(Current)),
+                                       std::memory_order_acq_rel)) {
+          Iter = Begin(Current);
+          return true;
+        }
+      }
+      return false;
+    }
+
+    bool Steal(size_t threadID, uint32_t& Seed) {
+      // xorshift32
+      Seed ^= Seed << 13;
+      Seed ^= Seed >> 17;
+      Seed ^= Seed << 5;
+      const size_t NbQueue = Queues.size();
+      const size_t First = Seed % NbQueue;
+      for(size_t n = 0; n < NbQueue; ++n) {
+        const size_t Victim = (First + n) % NbQueue;
+        if(Victim == threadID)
+          continue;
+        auto& Range = Queues[Victim].Range;
+        uint64_t Current = Range.load(std::memory_order_acquire);
+        while(Begin(Current) < End(Current)) {
+          const size_t Half = (End(Current) - Begin(Current) + 1) / 2;
+          const size_t Cut = End(Current) - Half;
+          if(Range.compare_exchange_weak(Current, Pack(Begin(Current), Cut),
+                                         std::memory_order_acq_rel)) {
+            // Our own queue is empty, so nobody else is updating it.
+            Queues[threadID].Range.store(Pack(Cut, End(Current)), std::memory_order_release);
+            return true;
+          }
+        }
+      }
+      return false;
+    }
+
+    StdThreadPool Pool;
+    std::vector<Queue> Queues;
 
 };
 
@@ -81,6 +418,18 @@ struct OpenMPExecutionEngine {
     }
   }
 
+  template<class F>
+  inline void operator()(size_t RowStart, size_t RowEnd, size_t RowStride,
+                         size_t ColStart, size_t ColEnd, size_t ColStride,
+                         F&& f) {
+#pragma omp parallel for collapse(2)
+    for(size_t j = ColStart; j < ColEnd; j += ColStride) {
+      for(size_t i = RowStart; i < RowEnd; i += RowStride) {
+        f(i, j);
+      }
+    }
+  }
+
 };
 #endif
 
@@ -97,23 +446,123 @@ struct Unquantize {
       size_t, size_t, size_t);
 };
 
-struct AddBias {
+/* Same as Unquantize, for B prepared by PrepareBPerColumn: column c is
+ * multiplied by unquant_mults[c], typically 1 / (quant_mult of A * quant_mults
+ * of B[c]). Loads follow Mode, as for AddBias below. */
+template <class Mode> struct BasicUnquantizePerColumn {
+  const float *unquant_mults;
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<int32_t, Arch> total,
+                                       size_t, size_t col_idx,
+                                       size_t col_size);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>>
+          total,
+      size_t, size_t col_idx, size_t col_size);
+};
+
+/* For A prepared by Shift::PrepareADynamic, with one unquantization
+ * multiplier per row, and B with one per column (all the same for B prepared
+ * by PrepareB). The shift of A towards unsigned values is usually undone by
+ * a bias from Shift::PrepareBias, but it now depends on the multiplier of
+ * each row, so it is undone here instead: shift_correction is the output of
+ * Shift::PrepareBias with UnquantizePerColumnAndWrite and the unquantization
+ * multipliers of B times -127. */
+template <class Mode> struct BasicUnquantizePerRowAndColumn {
+  const float *row_unquant_mults;
+  const float *col_unquant_mults;
+  const float *shift_correction;
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<int32_t, Arch> total,
+                                       size_t row_idx, size_t col_idx,
+                                       size_t col_size);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<int32_t, Arch>, xsimd::batch<int32_t, Arch>>
+          total,
+      size_t row_idx, size_t col_idx, size_t col_size);
+};
+
+/* AddBias and Write come in two flavours, selected by an xsimd alignment
+ * mode. With xsimd::aligned_mode, the bias and the output must be aligned on
+ * Arch::alignment(), and full registers are loaded and stored with aligned
+ * instructions whenever rows stay aligned. With xsimd::unaligned_mode, they
+ * may start anywhere, e.g. in tensors from a generic allocator. */
+template <class Mode> struct BasicAddBias {
   const float *bias_addr;
   template <class Arch>
   xsimd::batch<float, Arch> operator()(xsimd::batch<float, Arch> total, size_t, size_t col_idx,
-                  size_t);
+                  size_t col_size);
   template <class Arch>
   std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>>
   operator()(
       std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
-      size_t, size_t col_idx, size_t);
+      size_t, size_t col_idx, size_t col_size);
+};
+
+/* Activations, applied in registers after AddBias by
+ * UnquantizeAndAddBiasAndActivateAndWrite and
+ * UnquantizeAndAddBiasAndRequantize. */
+struct Identity {
+  template <class T> T operator()(T const &total, size_t, size_t, size_t) {
+    return total;
+  }
+};
+
+struct ReLU {
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<float, Arch> total, size_t,
+                                       size_t, size_t);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+      size_t, size_t, size_t);
+};
+
+// x * Phi(x), Phi being the standard normal CDF, computed with erf.
+struct GELU {
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<float, Arch> total, size_t,
+                                       size_t, size_t);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+      size_t, size_t, size_t);
 };
 
-struct Write {
+// Same as GELU, with the tanh approximation of Phi used by BERT and GPT-2.
+struct GELUTanh {
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<float, Arch> total, size_t,
+                                       size_t, size_t);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+      size_t, size_t, size_t);
+};
+
+// x * sigmoid(x), a.k.a. swish.
+struct SiLU {
+  template <class Arch>
+  xsimd::batch<float, Arch> operator()(xsimd::batch<float, Arch> total, size_t,
+                                       size_t, size_t);
+  template <class Arch>
+  std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> total,
+      size_t, size_t, size_t);
+};
+
+/* Rows of the output are ldc elements apart, or as many as there are columns
+ * of B when ldc is 0, e.g. to write into a block of columns of a larger
+ * matrix. */
+template <class Mode> struct BasicWrite {
   float *output_addr;
+  size_t ldc;
 
-  Write(float *o) : output_addr(o) {}
-  Write(int32_t *o) : output_addr(reinterpret_cast<float*>(o)) {}
+  BasicWrite(float *o, size_t ldc = 0) : output_addr(o), ldc(ldc) {}
+  BasicWrite(int32_t *o, size_t ldc = 0)
+      : output_addr(reinterpret_cast<float *>(o)), ldc(ldc) {}
 
   template <class Arch>
   void operator()(xsimd::batch<float, Arch> result, size_t row_idx,
@@ -134,35 +583,254 @@ struct Write {
       size_t row_idx, size_t col_idx, size_t col_size);
 };
 
-struct UnquantizeAndWrite {
+/* Quantizes the result to uint8 as Shift::PrepareA does, into rows of ldc
+ * bytes, so that the output can be fed as is to the Shift::Multiply of a next
+ * layer whose width is B_cols. ldc must then be B_cols rounded up to the
+ * register size (see Shift::PrepareA); the padding columns are left untouched,
+ * the matching rows of the prepared B being zero. */
+struct QuantizeUAndWrite {
+  uint8_t *output_addr;
+  float quant_mult;
+  size_t ldc;
+
+  template <class Arch>
+  void operator()(xsimd::batch<float, Arch> result, size_t row_idx,
+                  size_t col_idx, size_t col_size);
+
+  template <class Arch>
+  void operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> result,
+      size_t row_idx, size_t col_idx, size_t col_size);
+};
+
+/* Same as Write, but adds to the output already in place, scaled by beta:
+ * C = beta * C + result, e.g. to fuse a residual connection. With beta 0, C
+ * is not read, so it need not be initialized. */
+template <class Mode> struct BasicAccumulate {
+  float *output_addr;
+  float beta;
+  size_t ldc;
+
+  BasicAccumulate(float *o, float beta = 1.0f, size_t ldc = 0)
+      : output_addr(o), beta(beta), ldc(ldc) {}
+
+  template <class Arch>
+  void operator()(xsimd::batch<float, Arch> result, size_t row_idx,
+                  size_t col_idx, size_t col_size);
+
+  template <class Arch>
+  void operator()(
+      std::tuple<xsimd::batch<float, Arch>, xsimd::batch<float, Arch>> result,
+      size_t row_idx, size_t col_idx, size_t col_size);
+};
+
+template <class Mode> struct BasicUnquantizeAndWrite {
 
   Unquantize unquantize;
-  Write write;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizeAndWrite(float factor, float *output, size_t ldc = 0)
+      : unquantize{factor}, write{output, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+template <class Mode> struct BasicUnquantizePerColumnAndWrite {
+
+  BasicUnquantizePerColumn<Mode> unquantize;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizePerColumnAndWrite(const float *factors, float *output,
+                                   size_t ldc = 0)
+      : unquantize{factors}, write{output, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+template <class Mode> struct BasicUnquantizePerColumnAndAddBiasAndWrite {
 
-  UnquantizeAndWrite(float factor, float *output)
-      : unquantize{factor}, write{output} {}
+  BasicUnquantizePerColumn<Mode> unquantize;
+  BasicAddBias<Mode> add_bias;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizePerColumnAndAddBiasAndWrite(const float *factors,
+                                             const float *bias, float *output,
+                                             size_t ldc = 0)
+      : unquantize{factors}, add_bias{bias}, write{output, ldc} {}
 
   template <class T>
   void operator()(T const &total, size_t row_idx, size_t col_idx,
                   size_t col_size);
 };
 
-struct UnquantizeAndAddBiasAndWrite {
+template <class Mode> struct BasicUnquantizePerRowAndColumnAndAddBiasAndWrite {
+
+  BasicUnquantizePerRowAndColumn<Mode> unquantize;
+  BasicAddBias<Mode> add_bias;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizePerRowAndColumnAndAddBiasAndWrite(
+      const float *row_factors, const float *col_factors,
+      const float *shift_correction, const float *bias, float *output,
+      size_t ldc = 0)
+      : unquantize{row_factors, col_factors, shift_correction},
+        add_bias{bias}, write{output, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+template <class Mode> struct BasicUnquantizeAndAddBiasAndWrite {
+
+  Unquantize unquantize;
+  BasicAddBias<Mode> add_bias;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizeAndAddBiasAndWrite(float factor, const float *bias,
+                                    float *output, size_t ldc = 0)
+      : unquantize{factor}, add_bias{bias}, write{output, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+template <class Mode> struct BasicUnquantizeAndAccumulate {
 
   Unquantize unquantize;
-  AddBias add_bias;
-  Write write;
+  BasicAccumulate<Mode> accumulate;
 
-  UnquantizeAndAddBiasAndWrite(float factor, const float *bias, float *output)
-      : unquantize{factor}, add_bias{bias}, write{output} {}
+  BasicUnquantizeAndAccumulate(float factor, float *output, float beta = 1.0f,
+                               size_t ldc = 0)
+      : unquantize{factor}, accumulate{output, beta, ldc} {}
 
   template <class T>
   void operator()(T const &total, size_t row_idx, size_t col_idx,
                   size_t col_size);
 };
 
+template <class Mode> struct BasicUnquantizeAndAddBiasAndAccumulate {
+
+  Unquantize unquantize;
+  BasicAddBias<Mode> add_bias;
+  BasicAccumulate<Mode> accumulate;
+
+  BasicUnquantizeAndAddBiasAndAccumulate(float factor, const float *bias,
+                                         float *output, float beta = 1.0f,
+                                         size_t ldc = 0)
+      : unquantize{factor}, add_bias{bias}, accumulate{output, beta, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+/* Activation is one of ReLU, GELU, GELUTanh and SiLU, or any callable with
+ * the same signature. */
+template <class Activation, class Mode>
+struct BasicUnquantizeAndAddBiasAndActivateAndWrite {
+
+  Unquantize unquantize;
+  BasicAddBias<Mode> add_bias;
+  Activation activate;
+  BasicWrite<Mode> write;
+
+  BasicUnquantizeAndAddBiasAndActivateAndWrite(float factor, const float *bias,
+                                               float *output, size_t ldc = 0,
+                                               Activation activate = {})
+      : unquantize{factor}, add_bias{bias}, activate(activate),
+        write{output, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+/* Requantizes the output of a layer into the prepared A of the next one,
+ * without going through a float matrix: output holds A_rows rows of ldc
+ * bytes, see QuantizeUAndWrite. */
+template <class Activation = Identity, class Mode = xsimd::aligned_mode>
+struct UnquantizeAndAddBiasAndRequantize {
+
+  Unquantize unquantize;
+  BasicAddBias<Mode> add_bias;
+  Activation activate;
+  QuantizeUAndWrite write;
+
+  UnquantizeAndAddBiasAndRequantize(float factor, const float *bias,
+                                    uint8_t *output, float quant_mult,
+                                    size_t ldc, Activation activate = {})
+      : unquantize{factor}, add_bias{bias}, activate(activate),
+        write{output, quant_mult, ldc} {}
+
+  template <class T>
+  void operator()(T const &total, size_t row_idx, size_t col_idx,
+                  size_t col_size);
+};
+
+using AddBias = BasicAddBias<xsimd::aligned_mode>;
+using Write = BasicWrite<xsimd::aligned_mode>;
+using UnquantizeAndWrite = BasicUnquantizeAndWrite<xsimd::aligned_mode>;
+using UnquantizeAndAddBiasAndWrite =
+    BasicUnquantizeAndAddBiasAndWrite<xsimd::aligned_mode>;
+using Accumulate = BasicAccumulate<xsimd::aligned_mode>;
+using UnquantizeAndAccumulate =
+    BasicUnquantizeAndAccumulate<xsimd::aligned_mode>;
+using UnquantizeAndAddBiasAndAccumulate =
+    BasicUnquantizeAndAddBiasAndAccumulate<xsimd::aligned_mode>;
+template <class Activation>
+using UnquantizeAndAddBiasAndActivateAndWrite =
+    BasicUnquantizeAndAddBiasAndActivateAndWrite<Activation,
+                                                 xsimd::aligned_mode>;
+using UnquantizePerColumn = BasicUnquantizePerColumn<xsimd::aligned_mode>;
+using UnquantizePerColumnAndWrite =
+    BasicUnquantizePerColumnAndWrite<xsimd::aligned_mode>;
+using UnquantizePerColumnAndAddBiasAndWrite =
+    BasicUnquantizePerColumnAndAddBiasAndWrite<xsimd::aligned_mode>;
+using UnquantizePerRowAndColumn =
+    BasicUnquantizePerRowAndColumn<xsimd::aligned_mode>;
+using UnquantizePerRowAndColumnAndAddBiasAndWrite =
+    BasicUnquantizePerRowAndColumnAndAddBiasAndWrite<xsimd::aligned_mode>;
+
+using AddBiasUnaligned = BasicAddBias<xsimd::unaligned_mode>;
+using WriteUnaligned = BasicWrite<xsimd::unaligned_mode>;
+using UnquantizeAndWriteUnaligned =
+    BasicUnquantizeAndWrite<xsimd::unaligned_mode>;
+using UnquantizeAndAddBiasAndWriteUnaligned =
+    BasicUnquantizeAndAddBiasAndWrite<xsimd::unaligned_mode>;
+using AccumulateUnaligned = BasicAccumulate<xsimd::unaligned_mode>;
+using UnquantizeAndAccumulateUnaligned =
+    BasicUnquantizeAndAccumulate<xsimd::unaligned_mode>;
+using UnquantizeAndAddBiasAndAccumulateUnaligned =
+    BasicUnquantizeAndAddBiasAndAccumulate<xsimd::unaligned_mode>;
+template <class Activation>
+using UnquantizeAndAddBiasAndActivateAndWriteUnaligned =
+    BasicUnquantizeAndAddBiasAndActivateAndWrite<Activation,
+                                                 xsimd::unaligned_mode>;
+using UnquantizePerColumnUnaligned =
+    BasicUnquantizePerColumn<xsimd::unaligned_mode>;
+using UnquantizePerColumnAndWriteUnaligned =
+    BasicUnquantizePerColumnAndWrite<xsimd::unaligned_mode>;
+using UnquantizePerColumnAndAddBiasAndWriteUnaligned =
+    BasicUnquantizePerColumnAndAddBiasAndWrite<xsimd::unaligned_mode>;
+using UnquantizePerRowAndColumnUnaligned =
+    BasicUnquantizePerRowAndColumn<xsimd::unaligned_mode>;
+using UnquantizePerRowAndColumnAndAddBiasAndWriteUnaligned =
+    BasicUnquantizePerRowAndColumnAndAddBiasAndWrite<xsimd::unaligned_mode>;
+
 } // namespace callbacks
 
+// Returned by VectorMeanStd.
+struct MeanStd {
+  float mean;
+  float stddev;
+};
+
 //
 // Arch-specific implementation of each routine
 //
@@ -174,6 +842,23 @@ template <class Arch> struct Engine {
   static void Quantize(const float *const input, int8_t *const output,
                        float quant_mult, size_t size);
 
+  // Statistics over [begin, end), to pick quant_mult, e.g. 127 over
+  // MaxAbsolute. Large arrays are split in chunks across the engine, whose
+  // partial results are combined in a fixed order.
+  template <class ExecutionEngine>
+  static float MaxAbsolute(const float *begin, const float *end,
+                           ExecutionEngine &engine);
+
+  // Smallest and largest value, +inf and -inf for an empty range.
+  template <class ExecutionEngine>
+  static std::pair<float, float> MinMax(const float *begin, const float *end,
+                                        ExecutionEngine &engine);
+
+  // Mean and standard deviation of the values, or of their absolute values.
+  template <class ExecutionEngine>
+  static MeanStd VectorMeanStd(const float *begin, const float *end,
+                               bool absolute, ExecutionEngine &engine);
+
   template <typename IntegerTy>
   static void SelectColumnsB(const int8_t *input, int8_t *output, size_t rows,
                              const IntegerTy *cols_begin,
@@ -185,28 +870,148 @@ template <class Arch> struct Engine {
   static void PrepareBQuantizedTransposed(const int8_t *input, int8_t *output,
                                           size_t cols, size_t rows);
 
+  // Same as PrepareB, input being B already quantized, rows by cols.
   static void PrepareBQuantized(const int8_t *input, int8_t *output,
                                 size_t cols, size_t rows);
 
+  // Same as the above and PrepareB, blocks of 8 columns of B being spread
+  // across engine.
+  template <class ExecutionEngine>
+  static void PrepareBTransposed(const float *input, int8_t *output,
+                                 float quant_mult, size_t cols, size_t rows,
+                                 ExecutionEngine &engine);
+
+  template <class ExecutionEngine>
+  static void PrepareBQuantizedTransposed(const int8_t *input, int8_t *output,
+                                          size_t cols, size_t rows,
+                                          ExecutionEngine &engine);
+
+  template <class ExecutionEngine>
+  static void PrepareBQuantized(const int8_t *input, int8_t *output,
+                                size_t cols, size_t rows,
+                                ExecutionEngine &engine);
+
+  template <class ExecutionEngine>
+  static void PrepareB(const float *input, int8_t *output_shadow,
+                       float quant_mult, size_t rows, size_t cols,
+                       ExecutionEngine &engine);
+
+  // Neither dimension needs to be a multiple of anything: rows (the shared
+  // dimension) are padded with zeros to a multiple of the register size, and
+  // the last block of 8 columns is padded with zeros, so output holds
+  // round_up(rows, register size) * round_up(cols, 8) bytes. The same goes
+  // for the other PrepareB variants and SelectColumnsB, while the callbacks
+  // of Multiply and PrepareBias only write the actual columns.
   static void PrepareB(const float *input, int8_t *output_shadow,
                        float quant_mult, size_t rows, size_t cols);
 
+  // Same as PrepareB and PrepareBTransposed, column c of B being multiplied
+  // by quant_mults[c]. The output is then unquantized with
+  // UnquantizePerColumn.
+  static void PrepareBPerColumn(const float *input, int8_t *output,
+                                const float *quant_mults, size_t rows,
+                                size_t cols);
+  static void PrepareBTransposedPerColumn(const float *input, int8_t *output,
+                                          const float *quant_mults,
+                                          size_t cols, size_t rows);
+
+  // Each row is padded with zeros to a multiple of the register size, so
+  // output holds rows * round_up(cols, register size) bytes. Same for
+  // Shift::PrepareA.
   static void PrepareA(const float *input, int8_t *output, float quant_mult,
                        size_t rows, size_t cols);
 
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+  // Same as PrepareB, but in the layout of Shift::MultiplyAMX: each block of
+  // 16 columns is a sequence of 16x64-byte AMX tiles, one per 64 rows, each
+  // tile row holding 4 consecutive rows of the 16 columns. When cols is not a
+  // multiple of 16, the last 8 columns are laid out as by PrepareB.
+  static void PrepareBAMX(const float *input, int8_t *output, float quant_mult,
+                          size_t rows, size_t cols);
+#endif
+
+  // Signed A, as prepared by PrepareA, times B, as prepared by PrepareB. No
+  // bias correction is needed, unlike Shift::Multiply.
+  template <class Callback, class ExecutionEngine>
+  static void Multiply(const int8_t *A, const int8_t *B, size_t A_rows,
+                       size_t width, size_t B_cols, Callback callback,
+                       ExecutionEngine &engine);
+
   struct Shift {
 
     static void PrepareA(const float *input, uint8_t *output, float quant_mult,
                          size_t rows, size_t cols);
 
+    // Same as PrepareA, rows of input being lda floats apart, e.g. to read a
+    // block of columns of a larger matrix.
+    static void PrepareAStrided(const float *input, uint8_t *output,
+                                float quant_mult, size_t rows, size_t cols,
+                                size_t lda);
+
+    // Same as PrepareA, each row being quantized with its own multiplier,
+    // 127 over its largest absolute value, in the same pass as the scan for
+    // that value. unquant_mults receives one over each multiplier, for
+    // UnquantizePerRowAndColumn.
+    static void PrepareADynamic(const float *input, uint8_t *output,
+                                float *unquant_mults, size_t rows,
+                                size_t cols);
+
     template <class Callback, class ExecutionEngine>
     static void Multiply(const uint8_t *A, const int8_t *B, size_t A_rows,
                          size_t width, size_t B_cols, Callback callback,
                          ExecutionEngine& engine);
 
+    // Same as Multiply, rows of A being lda bytes apart rather than width
+    // rounded up to the register size. lda and A must be aligned on the
+    // register size.
+    template <class Callback, class ExecutionEngine>
+    static void MultiplyStrided(const uint8_t *A, const int8_t *B,
+                                size_t A_rows, size_t width, size_t B_cols,
+                                size_t lda, Callback callback,
+                                ExecutionEngine &engine);
+
+    // Same as Multiply for a single row of A, which Multiply forwards to.
+    // Streams B once, prefetching it.
+    template <class Callback, class ExecutionEngine>
+    static void MultiplyVector(const uint8_t *A, const int8_t *B, size_t width,
+                               size_t B_cols, Callback callback,
+                               ExecutionEngine &engine);
+
+    // Same as Multiply, with the shared dimension and the columns of B tiled
+    // for the given cache sizes. Multiply uses GEMMOLOGY_L1_CACHE_SIZE and
+    // GEMMOLOGY_L2_CACHE_SIZE.
+    template <size_t L1CacheSize, size_t L2CacheSize, class Callback,
+              class ExecutionEngine>
+    static void MultiplyBlocked(const uint8_t *A, const int8_t *B,
+                                size_t A_rows, size_t width, size_t B_cols,
+                                Callback callback, ExecutionEngine &engine);
+
+    // Same as Multiply, but also splits width across tasks. Meant for a large
+    // width and few columns of B.
+    template <class Callback, class ExecutionEngine>
+    static void MultiplySplitK(const uint8_t *A, const int8_t *B, size_t A_rows,
+                               size_t width, size_t B_cols, Callback callback,
+                               ExecutionEngine& engine);
+
     template <class Callback>
     static void PrepareBias(const int8_t *B, size_t width, size_t B_cols,
                             Callback C);
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+    // Same as Multiply, with B prepared by PrepareBAMX. Blocks of 16 rows of
+    // A go through AMX tiles, remaining rows through AVX512-VNNI, as does
+    // everything when the OS does not grant AMX to the process.
+    template <class Callback, class ExecutionEngine>
+    static void MultiplyAMX(const uint8_t *A, const int8_t *B, size_t A_rows,
+                            size_t width, size_t B_cols, Callback callback,
+                            ExecutionEngine &engine);
+
+    // Same as PrepareBias, with B prepared by PrepareBAMX.
+    template <class Callback>
+    static void PrepareBiasAMX(const int8_t *B, size_t width, size_t B_cols,
+                               Callback C);
+#endif
+
   };
 };
 
@@ -214,19 +1019,41 @@ template <class Arch> struct Engine {
 // Top-level wrappers that mostly match intgemm API
 //
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch>
 inline void QuantizeU(const float *input, uint8_t *output, float quant_mult,
                       size_t size) {
   return Engine<Arch>::QuantizeU(input, output, quant_mult, size);
 }
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch>
 inline void Quantize(const float *const input, int8_t *const output,
                      float quant_mult, size_t size) {
   return Engine<Arch>::Quantize(input, output, quant_mult, size);
 }
 
-template <class Arch = xsimd::default_arch, typename IntegerTy>
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
+inline float MaxAbsolute(const float *begin, const float *end,
+                         ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::MaxAbsolute(begin, end, engine);
+}
+
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
+inline std::pair<float, float> MinMax(const float *begin, const float *end,
+                                      ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::MinMax(begin, end, engine);
+}
+
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
+inline MeanStd VectorMeanStd(const float *begin, const float *end,
+                             bool absolute = false,
+                             ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::VectorMeanStd(begin, end, absolute, engine);
+}
+
+template <class Arch = default_arch, typename IntegerTy>
 inline void SelectColumnsB(const int8_t *input, int8_t *output, size_t rows,
                            const IntegerTy *cols_begin,
                            const IntegerTy *cols_end) {
@@ -234,57 +1061,150 @@ inline void SelectColumnsB(const int8_t *input, int8_t *output, size_t rows,
                                       cols_end);
 }
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
 inline void PrepareBTransposed(const float *input, int8_t *output,
-                               float quant_mult, size_t cols, size_t rows) {
+                               float quant_mult, size_t cols, size_t rows,
+                               ExecutionEngine &&engine = {}) {
   return Engine<Arch>::PrepareBTransposed(input, output, quant_mult, cols,
-                                          rows);
+                                          rows, engine);
 }
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
 inline void PrepareBQuantized(const int8_t *input, int8_t *output,
-                                        size_t cols, size_t rows) {
-  return Engine<Arch>::PrepareBQuantized(input, output, cols, rows);
+                              size_t cols, size_t rows,
+                              ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::PrepareBQuantized(input, output, cols, rows, engine);
 }
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
 inline void PrepareBQuantizedTransposed(const int8_t *input, int8_t *output,
-                                        size_t cols, size_t rows) {
-  return Engine<Arch>::PrepareBQuantizedTransposed(input, output, cols, rows);
+                                        size_t cols, size_t rows,
+                                        ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::PrepareBQuantizedTransposed(input, output, cols, rows,
+                                                   engine);
 }
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch,
+          class ExecutionEngine = SequentialExecutionEngine>
 inline void PrepareB(const float *input, int8_t *output_shadow,
-                     float quant_mult, size_t rows, size_t cols) {
-  return Engine<Arch>::PrepareB(input, output_shadow, quant_mult, rows, cols);
+                     float quant_mult, size_t rows, size_t cols,
+                     ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::PrepareB(input, output_shadow, quant_mult, rows, cols,
+                                engine);
+}
+
+template <class Arch = default_arch>
+inline void PrepareBPerColumn(const float *input, int8_t *output,
+                              const float *quant_mults, size_t rows,
+                              size_t cols) {
+  return Engine<Arch>::PrepareBPerColumn(input, output, quant_mults, rows,
+                                         cols);
+}
+
+template <class Arch = default_arch>
+inline void PrepareBTransposedPerColumn(const float *input, int8_t *output,
+                                        const float *quant_mults, size_t cols,
+                                        size_t rows) {
+  return Engine<Arch>::PrepareBTransposedPerColumn(input, output, quant_mults,
+                                                   cols, rows);
 }
 
-template <class Arch = xsimd::default_arch>
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+template <class Arch = default_arch>
+inline void PrepareBAMX(const float *input, int8_t *output, float quant_mult,
+                        size_t rows, size_t cols) {
+  return Engine<Arch>::PrepareBAMX(input, output, quant_mult, rows, cols);
+}
+#endif
+
+template <class Arch = default_arch>
 inline void PrepareA(const float *input, int8_t *output, float quant_mult,
                      size_t rows, size_t cols) {
   return Engine<Arch>::PrepareA(input, output, quant_mult, rows, cols);
 }
 
+template <class Arch = default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
+inline void Multiply(const int8_t *A, const int8_t *B, size_t A_rows,
+                     size_t width, size_t B_cols, Callback C, ExecutionEngine&& engine={}) {
+  return Engine<Arch>::Multiply(A, B, A_rows, width, B_cols, C, engine);
+}
+
 namespace Shift {
 
-template <class Arch = xsimd::default_arch>
+template <class Arch = default_arch>
 inline void PrepareA(const float *input, uint8_t *output, float quant_mult,
                      size_t rows, size_t cols) {
   return Engine<Arch>::Shift::PrepareA(input, output, quant_mult, rows, cols);
 }
 
-template <class Arch = xsimd::default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
+template <class Arch = default_arch>
+inline void PrepareAStrided(const float *input, uint8_t *output,
+                            float quant_mult, size_t rows, size_t cols,
+                            size_t lda) {
+  return Engine<Arch>::Shift::PrepareAStrided(input, output, quant_mult, rows,
+                                              cols, lda);
+}
+
+template <class Arch = default_arch>
+inline void PrepareADynamic(const float *input, uint8_t *output,
+                            float *unquant_mults, size_t rows, size_t cols) {
+  return Engine<Arch>::Shift::PrepareADynamic(input, output, unquant_mults,
+                                              rows, cols);
+}
+
+template <class Arch = default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
 inline void Multiply(const uint8_t *A, const int8_t *B, size_t A_rows,
                      size_t width, size_t B_cols, Callback C, ExecutionEngine&& engine={}) {
   return Engine<Arch>::Shift::Multiply(A, B, A_rows, width, B_cols, C, engine);
 }
 
-template <class Arch = xsimd::default_arch, class Callback>
+template <class Arch = default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
+inline void MultiplyStrided(const uint8_t *A, const int8_t *B, size_t A_rows,
+                            size_t width, size_t B_cols, size_t lda, Callback C,
+                            ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::Shift::MultiplyStrided(A, B, A_rows, width, B_cols, lda,
+                                              C, engine);
+}
+
+template <size_t L1CacheSize, size_t L2CacheSize,
+          class Arch = default_arch, class Callback,
+          class ExecutionEngine = SequentialExecutionEngine>
+inline void MultiplyBlocked(const uint8_t *A, const int8_t *B, size_t A_rows,
+                            size_t width, size_t B_cols, Callback C,
+                            ExecutionEngine &&engine = {}) {
+  return Engine<Arch>::Shift::template MultiplyBlocked<L1CacheSize, L2CacheSize>(
+      A, B, A_rows, width, B_cols, C, engine);
+}
+
+template <class Arch = default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
+inline void MultiplySplitK(const uint8_t *A, const int8_t *B, size_t A_rows,
+                           size_t width, size_t B_cols, Callback C, ExecutionEngine&& engine={}) {
+  return Engine<Arch>::Shift::MultiplySplitK(A, B, A_rows, width, B_cols, C, engine);
+}
+
+template <class Arch = default_arch, class Callback>
 inline void PrepareBias(const int8_t *B, size_t width, size_t B_cols,
                         Callback C) {
   return Engine<Arch>::Shift::PrepareBias(B, width, B_cols, C);
 }
 
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+template <class Arch = default_arch, class Callback, class ExecutionEngine=SequentialExecutionEngine>
+inline void MultiplyAMX(const uint8_t *A, const int8_t *B, size_t A_rows,
+                        size_t width, size_t B_cols, Callback C, ExecutionEngine&& engine={}) {
+  return Engine<Arch>::Shift::MultiplyAMX(A, B, A_rows, width, B_cols, C, engine);
+}
+
+template <class Arch = default_arch, class Callback>
+inline void PrepareBiasAMX(const int8_t *B, size_t width, size_t B_cols,
+                           Callback C) {
+  return Engine<Arch>::Shift::PrepareBiasAMX(B, width, B_cols, C);
+}
+#endif
+
 } // namespace Shift
 
 } // namespace gemmology
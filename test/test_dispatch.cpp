@@ -0,0 +1,194 @@
+#include "gemmology_dispatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+namespace {
+
+using gemmology::dispatch::Kernels;
+
+// Pool shared by all tests, the dispatched kernels running on the engine of
+// the caller.
+gemmology::StdThreadExecutionEngine &ThreadEngine() {
+  static gemmology::StdThreadExecutionEngine engine(4);
+  return engine;
+}
+
+// Exact products of the quantized matrices, through the kernels of one
+// architecture.
+bool TestKernels(const Kernels &kernels, int A_rows, int width, int B_cols) {
+  int A_size = A_rows * width;
+  int B_size = width * B_cols;
+  int C_size = A_rows * B_cols;
+  float *A, *B;
+  posix_memalign((void **)&A, 64, A_size * sizeof(*A));
+  posix_memalign((void **)&B, 64, B_size * sizeof(*B));
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::generate(A, A + A_size, [&]() { return dist(gen); });
+  std::generate(B, B + B_size, [&]() { return dist(gen); });
+
+  // Small enough for 16-bit intermediate sums not to saturate.
+  float quant_mult = 127.0f / 2.0f;
+
+  uint8_t *A_prep;
+  int8_t *B_quant, *B_prep;
+  posix_memalign((void **)&A_prep, 64, A_size * sizeof(*A_prep));
+  posix_memalign((void **)&B_quant, 64, B_size * sizeof(*B_quant));
+  posix_memalign((void **)&B_prep, 64, B_size * sizeof(*B_prep));
+  kernels.PrepareA(A, A_prep, quant_mult, A_rows, width);
+  kernels.Quantize(B, B_quant, quant_mult, B_size);
+  kernels.PrepareB(B, B_prep, quant_mult, width, B_cols);
+
+  std::vector<int32_t> ref_C(C_size), ref_bias(B_cols);
+  for (int r = 0; r < A_rows; ++r)
+    for (int c = 0; c < B_cols; ++c)
+      for (int k = 0; k < width; ++k)
+        ref_C[r * B_cols + c] +=
+            int32_t(A_prep[r * width + k]) * int32_t(B_quant[k * B_cols + c]);
+  for (int k = 0; k < width; ++k)
+    for (int c = 0; c < B_cols; ++c)
+      ref_bias[c] += B_quant[k * B_cols + c];
+
+  int32_t *test_C;
+  posix_memalign((void **)&test_C, 64, C_size * sizeof(*test_C));
+  std::get<Kernels::MultiplyFn<gemmology::callbacks::Write>>(kernels.Multiply)(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::Write(test_C));
+  bool res = std::equal(ref_C.begin(), ref_C.end(), test_C);
+  if (!res)
+    std::cerr << kernels.name << ": multiply mismatch\n";
+
+  std::fill(test_C, test_C + C_size, 0);
+  std::get<Kernels::MultiplyWithEngineFn<gemmology::callbacks::Write>>(
+      kernels.MultiplyWithEngine)(A_prep, B_prep, A_rows, width, B_cols,
+                                  gemmology::callbacks::Write(test_C),
+                                  ThreadEngine());
+  if (!std::equal(ref_C.begin(), ref_C.end(), test_C)) {
+    std::cerr << kernels.name << ": multiply mismatch with an engine\n";
+    res = false;
+  }
+
+  std::get<Kernels::PrepareBiasFn<gemmology::callbacks::Write>>(
+      kernels.PrepareBias)(B_prep, width, B_cols,
+                           gemmology::callbacks::Write(test_C));
+  if (!std::equal(ref_bias.begin(), ref_bias.end(), test_C)) {
+    std::cerr << kernels.name << ": bias mismatch\n";
+    res = false;
+  }
+
+  free(A);
+  free(B);
+  free(A_prep);
+  free(B_quant);
+  free(B_prep);
+  free(test_C);
+  return res;
+}
+
+template <class Arch> bool TestArch() {
+  if (!gemmology::dispatch::Supported<Arch>()) {
+    std::cout << Arch::name() << ": not supported, skipped\n";
+    return true;
+  }
+  const Kernels &kernels = gemmology::dispatch::KernelsFor<Arch>();
+  return TestKernels(kernels, 8, 256, 256) && TestKernels(kernels, 1, 64, 8) &&
+         TestKernels(kernels, 17, 512, 24);
+}
+
+// Through the top-level functions, against the float product.
+bool TestSelected() {
+  const int A_rows = 5, width = 256, B_cols = 64;
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::vector<float> A(A_rows * width), B(width * B_cols), bias(B_cols);
+  std::generate(A.begin(), A.end(), [&]() { return dist(gen); });
+  std::generate(B.begin(), B.end(), [&]() { return dist(gen); });
+  std::generate(bias.begin(), bias.end(), [&]() { return dist(gen); });
+  std::vector<float> prepared_bias = bias;
+
+  float alpha = 2.0f;
+  float quant_mult = 127.0f / alpha;
+  float unquant_mult = 1.0f / (quant_mult * quant_mult);
+  float unquant_mult_forprep = -alpha * alpha / 127.0f;
+
+  uint8_t *A_prep;
+  int8_t *B_prep;
+  float *C;
+  bool res = true;
+  posix_memalign((void **)&A_prep, 64, A.size());
+  posix_memalign((void **)&B_prep, 64, B.size());
+  posix_memalign((void **)&C, 64, A_rows * B_cols * sizeof(float));
+  gemmology::dispatch::Shift::PrepareA(A.data(), A_prep, quant_mult, A_rows,
+                                       width);
+  gemmology::dispatch::PrepareB(B.data(), B_prep, quant_mult, width, B_cols);
+  gemmology::dispatch::Shift::PrepareBias(
+      B_prep, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+          unquant_mult_forprep, prepared_bias.data(), prepared_bias.data()));
+  gemmology::dispatch::Shift::Multiply(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+          unquant_mult, prepared_bias.data(), C));
+
+  // Same on the pool, which must give the same floats.
+  std::vector<float> threaded_C(A_rows * B_cols);
+  gemmology::dispatch::Shift::Multiply(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+          unquant_mult, prepared_bias.data(), threaded_C.data()),
+      ThreadEngine());
+  if (!std::equal(threaded_C.begin(), threaded_C.end(), C)) {
+    std::cerr << gemmology::dispatch::Selected().name
+              << ": mismatch with an engine\n";
+    res = false;
+  }
+
+  for (int r = 0; r < A_rows; ++r)
+    for (int c = 0; c < B_cols; ++c) {
+      double expected = bias[c];
+      for (int k = 0; k < width; ++k)
+        expected += double(A[r * width + k]) * B[k * B_cols + c];
+      if (std::abs(expected - C[r * B_cols + c]) > 0.3) {
+        std::cerr << gemmology::dispatch::Selected().name
+                  << ": inaccurate at " << r << ' ' << c << ": " << expected
+                  << " vs " << C[r * B_cols + c] << "\n";
+        res = false;
+        break;
+      }
+    }
+  free(A_prep);
+  free(B_prep);
+  free(C);
+  return res;
+}
+
+} // namespace
+
+int main() {
+  if (!TestArch<xsimd::sse2>())
+    return 1;
+  if (!TestArch<xsimd::ssse3>())
+    return 1;
+  if (!TestArch<xsimd::sse4_2>())
+    return 1;
+  if (!TestArch<xsimd::avx2>())
+    return 1;
+  if (!TestArch<xsimd::avxvnni>())
+    return 1;
+  if (!TestArch<xsimd::avx512bw>())
+    return 1;
+  if (!TestArch<xsimd::avx512vnni<xsimd::avx512bw>>())
+    return 1;
+
+  std::cout << "selected: " << gemmology::dispatch::Selected().name << "\n";
+  if (!TestSelected())
+    return 1;
+
+  return 0;
+}
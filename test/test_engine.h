@@ -0,0 +1,18 @@
+#ifndef GEMMOLOGY_TEST_ENGINE_H
+#define GEMMOLOGY_TEST_ENGINE_H
+
+#include "gemmology.h"
+
+// Execution engine shared by all tests, so that reusing it gets tested too.
+inline auto &TestEngine() {
+#if defined(_OPENMP)
+  static gemmology::OpenMPExecutionEngine engine;
+#elif defined(GEMMOLOGY_WITH_STD_THREAD)
+  static gemmology::StdThreadExecutionEngine engine(4);
+#else
+  static gemmology::SequentialExecutionEngine engine;
+#endif
+  return engine;
+}
+
+#endif
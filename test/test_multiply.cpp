@@ -1,4 +1,5 @@
 #include "gemmology.h"
+#include "test_engine.h"
 
 #include <algorithm>
 #include <cassert>
@@ -8,9 +9,11 @@
 #include <cstring>
 #include <iomanip>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <numeric>
 #include <random>
+#include <vector>
 
 namespace {
 
@@ -74,6 +77,18 @@ bool CompareMSE(const float *float_ref, const float *int_ref,
   return true;
 }
 
+// Width of A and B once prepared, padded to a whole number of registers.
+int PaddedWidth(int width) {
+  constexpr int kRegister = sizeof(xsimd::batch<int8_t>);
+  return (width + kRegister - 1) / kRegister * kRegister;
+}
+
+// Size of B once prepared, its rows and its last block of 8 columns being
+// padded.
+int PreparedSize(int rows, int cols) {
+  return PaddedWidth(rows) * ((cols + 7) / 8 * 8);
+}
+
 template <typename Type>
 void RearragementRef(const Type *input, Type *output, int simd, int unroll,
                      int rows, int cols) {
@@ -112,6 +127,76 @@ void MultiplyRef(const TypeA *A, const TypeB *B, TypeC *C, int A_rows,
   }
 }
 
+// Execution engine implementing the 1D protocol only.
+struct LinearExecutionEngine {
+  template <class F>
+  void operator()(size_t Start, size_t End, size_t Stride, F &&f) {
+    for (size_t i = Start; i < End; i += Stride)
+      f(i);
+  }
+};
+
+// Random A, B and bias in [-1, 1], A prepared for Shift::Multiply and B for
+// any Multiply. The tests of Shift::Multiply and its callbacks start from this
+// and only add what they check.
+struct ShiftMultiplySetup {
+  const int A_rows, width, B_cols;
+  const int A_size = A_rows * width;
+  const int B_size = width * B_cols;
+  const int C_size = A_rows * B_cols;
+  const float quant_mult = 127.0f / 2.0f;
+  const float unquant_mult = 1.0f / (quant_mult * quant_mult);
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist{-1.0f, 1.0f};
+  float *A, *B, *bias, *ref_C, *test_C;
+  uint8_t *A_prep;
+  int8_t *B_prep;
+
+  ShiftMultiplySetup(int A_rows, int width, int B_cols)
+      : A_rows(A_rows), width(width), B_cols(B_cols) {
+    posix_memalign((void **)&A, 64, A_size * sizeof(*A));
+    posix_memalign((void **)&B, 64, B_size * sizeof(*B));
+    posix_memalign((void **)&bias, 64, B_cols * sizeof(*bias));
+    posix_memalign((void **)&ref_C, 64, C_size * sizeof(*ref_C));
+    posix_memalign((void **)&test_C, 64, C_size * sizeof(*test_C));
+    posix_memalign((void **)&A_prep, 64,
+                   A_rows * PaddedWidth(width) * sizeof(*A_prep));
+    posix_memalign((void **)&B_prep, 64,
+                   PreparedSize(width, B_cols) * sizeof(*B_prep));
+    Generate(A, A_size);
+    Generate(B, B_size);
+    Generate(bias, B_cols);
+    gemmology::Shift::PrepareA(A, A_prep, quant_mult, A_rows, width);
+    gemmology::PrepareB(B, B_prep, quant_mult, width, B_cols);
+  }
+
+  ShiftMultiplySetup(const ShiftMultiplySetup &) = delete;
+  ShiftMultiplySetup &operator=(const ShiftMultiplySetup &) = delete;
+
+  ~ShiftMultiplySetup() {
+    free(A);
+    free(B);
+    free(bias);
+    free(ref_C);
+    free(test_C);
+    free(A_prep);
+    free(B_prep);
+  }
+
+  void Generate(float *output, int size) {
+    std::generate(output, output + size, [&]() { return dist(gen); });
+  }
+
+  // Reference output, unquantized with the bias added.
+  void ReferenceMultiply() {
+    gemmology::Shift::Multiply(
+        A_prep, B_prep, A_rows, width, B_cols,
+        gemmology::callbacks::UnquantizeAndAddBiasAndWrite(unquant_mult, bias,
+                                                           ref_C),
+        TestEngine());
+  }
+};
+
 #if defined(__AVX2__) && !defined(__AVX512BW__)
 bool TestPrepare(int rows, int cols) {
   int size = rows * cols;
@@ -153,6 +238,47 @@ bool TestPrepare(int rows, int cols) {
 }
 #endif
 
+bool TestPrepareBEngine(int rows, int cols) {
+  std::vector<float> input(rows * cols);
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::generate(input.begin(), input.end(), [&]() { return dist(gen); });
+
+  const int size = PreparedSize(rows, cols);
+  int8_t *ref, *test;
+  posix_memalign((void **)&ref, 64, size * sizeof(*ref));
+  posix_memalign((void **)&test, 64, size * sizeof(*test));
+  bool res = true;
+
+  gemmology::PrepareB(input.data(), ref, 64.f, rows, cols);
+  gemmology::PrepareB(input.data(), test, 64.f, rows, cols, TestEngine());
+  if (!std::equal(ref, ref + size, test)) {
+    std::cerr << "PrepareB differs with an execution engine\n";
+    res = false;
+  }
+
+  // PrepareBQuantized pads the same way, and gives the same bytes from B
+  // quantized beforehand.
+  int8_t *quantized;
+  posix_memalign((void **)&quantized, 64, rows * cols * sizeof(*quantized));
+  gemmology::Quantize(input.data(), quantized, 64.f, rows * cols);
+  gemmology::PrepareBQuantized(quantized, test, cols, rows);
+  if (!std::equal(ref, ref + size, test)) {
+    std::cerr << "PrepareBQuantized differs from PrepareB\n";
+    res = false;
+  }
+  gemmology::PrepareBQuantized(quantized, test, cols, rows, TestEngine());
+  if (!std::equal(ref, ref + size, test)) {
+    std::cerr << "PrepareBQuantized differs with an execution engine\n";
+    res = false;
+  }
+  free(quantized);
+
+  free(ref);
+  free(test);
+  return res;
+}
+
 bool TestPrepareA(int rows, int cols) {
   std::mt19937 gen;
   // Go somewhat out of range too.
@@ -181,7 +307,7 @@ bool TestPrepareA(int rows, int cols) {
   return res;
 }
 
-bool TestSelectColumnsB(int rows, int cols) {
+bool TestSelectColumnsB(int rows, int cols, int select_count = 24) {
   std::mt19937 gen;
   // Go somewhat out of range too.
   std::uniform_real_distribution<float> dist(-129.0, 129.0);
@@ -194,35 +320,35 @@ bool TestSelectColumnsB(int rows, int cols) {
   }
 
   int8_t *prepared;
-  posix_memalign((void **)&prepared, 64, size);
+  posix_memalign((void **)&prepared, 64, PreparedSize(rows, cols));
   gemmology::PrepareB(input, prepared, 1, rows, cols);
 
-  constexpr int kSelectCols = 24;
-  int select_cols[kSelectCols];
+  std::vector<int> select_cols(select_count);
   std::uniform_int_distribution<int> col_dist(0, cols - 1);
   for (auto &it : select_cols) {
     it = col_dist(gen);
   }
 
+  const int selected_size = PreparedSize(rows, select_count);
   int8_t *test;
-  posix_memalign((void **)&test, 64, rows * kSelectCols * sizeof(*test));
-  gemmology::SelectColumnsB(prepared, test, rows, select_cols,
-                            select_cols + kSelectCols);
+  posix_memalign((void **)&test, 64, selected_size * sizeof(*test));
+  gemmology::SelectColumnsB(prepared, test, rows, select_cols.data(),
+                            select_cols.data() + select_count);
 
   // Select columns manually in float space.
   float *selected;
   posix_memalign((void **)&selected, 64,
-                 rows * kSelectCols * sizeof(*selected));
+                 rows * select_count * sizeof(*selected));
   for (int r = 0; r < rows; ++r) {
-    for (int c = 0; c < kSelectCols; ++c) {
-      selected[c + r * kSelectCols] = input[select_cols[c] + r * cols];
+    for (int c = 0; c < select_count; ++c) {
+      selected[c + r * select_count] = input[select_cols[c] + r * cols];
     }
   }
 
   int8_t *ref;
-  posix_memalign((void **)&ref, 64, rows * kSelectCols * sizeof(*ref));
-  gemmology::PrepareB(selected, ref, 1, rows, kSelectCols);
-  if (memcmp(ref, test, sizeof(int8_t) * rows * kSelectCols) != 0) {
+  posix_memalign((void **)&ref, 64, selected_size * sizeof(*ref));
+  gemmology::PrepareB(selected, ref, 1, rows, select_count);
+  if (memcmp(ref, test, sizeof(int8_t) * selected_size) != 0) {
     std::cerr << "mismatch\n";
     return false;
   }
@@ -266,8 +392,10 @@ bool TestMultiplyShiftInt(int A_rows, int width, int B_cols,
 
   uint8_t *A_prep;
   int8_t *B_prep;
-  posix_memalign((void **)&A_prep, 64, A_size * sizeof(*A_prep));
-  posix_memalign((void **)&B_prep, 64, B_size * sizeof(*B_prep));
+  posix_memalign((void **)&A_prep, 64,
+                 A_rows * PaddedWidth(width) * sizeof(*A_prep));
+  posix_memalign((void **)&B_prep, 64,
+                 PreparedSize(width, B_cols) * sizeof(*B_prep));
   gemmology::Shift::PrepareA(A, A_prep, quant_mult, A_rows, width);
   gemmology::PrepareB(B, B_prep, quant_mult, width, B_cols);
 
@@ -281,6 +409,10 @@ bool TestMultiplyShiftInt(int A_rows, int width, int B_cols,
   int8_t *B_quant;
   posix_memalign((void **)&B_quant, 64, B_size * sizeof(*B_quant));
   gemmology::Quantize(B, B_quant, quant_mult, B_size);
+  // Same as A_prep, without the padding of its rows.
+  uint8_t *A_quant;
+  posix_memalign((void **)&A_quant, 64, A_size * sizeof(*A_quant));
+  gemmology::QuantizeU(A, A_quant, quant_mult, A_size);
   float *slowint_C;
   posix_memalign((void **)&slowint_C, 64, C_size * sizeof(*slowint_C));
   // Taking the original A_preparation which means A would be int8_t
@@ -322,27 +454,56 @@ bool TestMultiplyShiftInt(int A_rows, int width, int B_cols,
       B_prep, width, B_cols,
       gemmology::callbacks::UnquantizeAndAddBiasAndWrite(unquant_mult_forprep,
                                                          bias, bias));
-#if defined(_OPENMP)
-  gemmology::OpenMPExecutionEngine engine;
-#elif defined(GEMMOLOGY_WITH_STD_THREAD)
-  gemmology::StdThreadExecutionEngine engine(4);
-#else
-  gemmology::SequentialExecutionEngine engine;
-#endif
-
   gemmology::Shift::Multiply(A_prep, B_prep, A_rows, width, B_cols,
                              gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
-                                 unquant_mult, bias, test_C), engine);
+                                 unquant_mult, bias, test_C), TestEngine());
 
   // Reference INT VERSION HERE with ADD127
   // Taking the original A_preparation which means A would be int8_t
-  MultiplyRef(A_prep, B_quant, slowint_C, A_rows, width, B_cols,
+  MultiplyRef(A_quant, B_quant, slowint_C, A_rows, width, B_cols,
               [&](int32_t sum, int i, int j) {
                 return sum * unquant_mult + ShiftedBias[j];
               });
 
   bool res = CompareMSE(float_C, slowint_C, test_C, C_size, int_tolerance,
                     float_tolerance, MSE_float_tolerance, MSE_int_tolerance);
+
+#if defined(GEMMOLOGY_WITH_STD_THREAD)
+  // Work stealing must not change the result, only who computes it.
+  static gemmology::StdThreadWorkStealingExecutionEngine stealing_engine(3);
+  float *stolen_C;
+  posix_memalign((void **)&stolen_C, 64, C_size * sizeof(*stolen_C));
+  gemmology::Shift::Multiply(A_prep, B_prep, A_rows, width, B_cols,
+                             gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+                                 unquant_mult, bias, stolen_C), stealing_engine);
+  if (memcmp(test_C, stolen_C, C_size * sizeof(*stolen_C)) != 0) {
+    std::cerr << "work stealing mismatch\n";
+    res = false;
+  }
+  free(stolen_C);
+#endif
+
+  // Engines without a 2D overload go through Flatten2D.
+  float *linear_C;
+  posix_memalign((void **)&linear_C, 64, C_size * sizeof(*linear_C));
+  gemmology::Shift::Multiply(A_prep, B_prep, A_rows, width, B_cols,
+                             gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+                                 unquant_mult, bias, linear_C),
+                             LinearExecutionEngine());
+  if (memcmp(test_C, linear_C, C_size * sizeof(*linear_C)) != 0) {
+    std::cerr << "1D engine mismatch\n";
+    res = false;
+  }
+  gemmology::Shift::MultiplySplitK(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(unquant_mult, bias,
+                                                         linear_C),
+      LinearExecutionEngine());
+  if (memcmp(test_C, linear_C, C_size * sizeof(*linear_C)) != 0) {
+    std::cerr << "1D engine split-K mismatch\n";
+    res = false;
+  }
+  free(linear_C);
   free(A);
   free(B);
   free(bias);
@@ -350,6 +511,7 @@ bool TestMultiplyShiftInt(int A_rows, int width, int B_cols,
   free(B_prep);
   free(test_C);
   free(B_quant);
+  free(A_quant);
   free(slowint_C);
   free(float_C);
   free(A_prep2);
@@ -357,6 +519,594 @@ bool TestMultiplyShiftInt(int A_rows, int width, int B_cols,
   return res;
 }
 
+bool TestMultiplyBlocking(int A_rows, int width, int B_cols) {
+  int A_size = A_rows * width;
+  int B_size = width * B_cols;
+  int C_size = A_rows * B_cols;
+  float *A, *B, *bias;
+  posix_memalign((void **)&A, 64, A_size * sizeof(*A));
+  posix_memalign((void **)&B, 64, B_size * sizeof(*B));
+  posix_memalign((void **)&bias, 64, B_cols * sizeof(*bias));
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::generate(A, A + A_size, [&]() { return dist(gen); });
+  std::generate(B, B + B_size, [&]() { return dist(gen); });
+  std::generate(bias, bias + B_cols, [&]() { return dist(gen); });
+
+  float quant_mult = 127.0f / 2.0f;
+  float unquant_mult = 1.0f / (quant_mult * quant_mult);
+
+  uint8_t *A_prep;
+  int8_t *B_prep;
+  posix_memalign((void **)&A_prep, 64,
+                 A_rows * PaddedWidth(width) * sizeof(*A_prep));
+  posix_memalign((void **)&B_prep, 64,
+                 PreparedSize(width, B_cols) * sizeof(*B_prep));
+  gemmology::Shift::PrepareA(A, A_prep, quant_mult, A_rows, width);
+  gemmology::PrepareB(B, B_prep, quant_mult, width, B_cols);
+
+  float *ref_C, *test_C;
+  posix_memalign((void **)&ref_C, 64, C_size * sizeof(*ref_C));
+  posix_memalign((void **)&test_C, 64, C_size * sizeof(*test_C));
+  // Reference without any blocking.
+  gemmology::Shift::MultiplyBlocked<SIZE_MAX, SIZE_MAX>(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(unquant_mult, bias,
+                                                         ref_C),
+      TestEngine());
+  gemmology::Shift::MultiplySplitK(A_prep, B_prep, A_rows, width, B_cols,
+                                   gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+                                       unquant_mult, bias, test_C), TestEngine());
+
+  // Integer sums are exact, so splitting the shared dimension must not change
+  // anything.
+  bool res = memcmp(ref_C, test_C, C_size * sizeof(*test_C)) == 0;
+  if (!res)
+    std::cerr << "split-K mismatch\n";
+
+  // Same for blocking with caches small enough to get several slices of the
+  // shared dimension and groups of columns.
+  gemmology::Shift::MultiplyBlocked<4096, 32768>(
+      A_prep, B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(unquant_mult, bias,
+                                                         test_C),
+      TestEngine());
+  if (memcmp(ref_C, test_C, C_size * sizeof(*test_C)) != 0) {
+    std::cerr << "cache blocking mismatch\n";
+    res = false;
+  }
+
+  // And for Multiply, which takes a dedicated path for a single row of A.
+  gemmology::Shift::Multiply(A_prep, B_prep, A_rows, width, B_cols,
+                             gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+                                 unquant_mult, bias, test_C), TestEngine());
+  if (memcmp(ref_C, test_C, C_size * sizeof(*test_C)) != 0) {
+    std::cerr << "multiply mismatch\n";
+    res = false;
+  }
+
+  free(A);
+  free(B);
+  free(bias);
+  free(A_prep);
+  free(B_prep);
+  free(ref_C);
+  free(test_C);
+  return res;
+}
+
+bool TestMultiplyEmptyWidth(int A_rows, int B_cols) {
+  uint8_t *A_prep;
+  int8_t *B_prep;
+  float *test_C;
+  posix_memalign((void **)&A_prep, 64, 64 * sizeof(*A_prep));
+  posix_memalign((void **)&B_prep, 64, 64 * sizeof(*B_prep));
+  posix_memalign((void **)&test_C, 64, A_rows * B_cols * sizeof(*test_C));
+  bool res = true;
+
+  // An empty shared dimension leaves nothing to call back.
+  auto check = [&](const char *name, auto &&multiply) {
+    std::fill(test_C, test_C + A_rows * B_cols, 1.f);
+    multiply(gemmology::callbacks::UnquantizeAndWrite(1.f, test_C));
+    if (!std::all_of(test_C, test_C + A_rows * B_cols,
+                     [](float x) { return x == 1.f; })) {
+      std::cerr << name << " with an empty width wrote to C\n";
+      res = false;
+    }
+  };
+  check("Shift::Multiply", [&](auto callback) {
+    gemmology::Shift::Multiply(A_prep, B_prep, A_rows, 0, B_cols, callback,
+                               TestEngine());
+  });
+  check("split-K", [&](auto callback) {
+    gemmology::Shift::MultiplySplitK(A_prep, B_prep, A_rows, 0, B_cols,
+                                     callback, TestEngine());
+  });
+  check("Multiply", [&](auto callback) {
+    gemmology::Multiply(reinterpret_cast<const int8_t *>(A_prep), B_prep,
+                        A_rows, 0, B_cols, callback, TestEngine());
+  });
+
+  free(A_prep);
+  free(B_prep);
+  free(test_C);
+  return res;
+}
+
+bool TestMultiplyInt(int A_rows, int width, int B_cols) {
+  int A_size = A_rows * width;
+  int B_size = width * B_cols;
+  int C_size = A_rows * B_cols;
+  float *A, *B;
+  posix_memalign((void **)&A, 64, A_size * sizeof(*A));
+  posix_memalign((void **)&B, 64, B_size * sizeof(*B));
+  std::mt19937 gen;
+  // Go somewhat out of range too, so that saturation gets tested.
+  std::uniform_real_distribution<float> dist(-2.0f, 2.0f);
+  std::generate(A, A + A_size, [&]() { return dist(gen); });
+  std::generate(B, B + B_size, [&]() { return dist(gen); });
+
+  float quant_mult = 64;
+
+  int8_t *A_prep, *A_quant, *B_quant, *B_prep;
+  posix_memalign((void **)&A_prep, 64,
+                 A_rows * PaddedWidth(width) * sizeof(*A_prep));
+  posix_memalign((void **)&A_quant, 64, A_size * sizeof(*A_quant));
+  posix_memalign((void **)&B_quant, 64, B_size * sizeof(*B_quant));
+  posix_memalign((void **)&B_prep, 64,
+                 PreparedSize(width, B_cols) * sizeof(*B_prep));
+  gemmology::PrepareA(A, A_prep, quant_mult, A_rows, width);
+  gemmology::Quantize(A, A_quant, quant_mult, A_size);
+  gemmology::Quantize(B, B_quant, quant_mult, B_size);
+  gemmology::PrepareB(B, B_prep, quant_mult, width, B_cols);
+
+  // A few more values after C, to check that nothing gets written past its
+  // last column.
+  constexpr int kGuard = 8;
+  int32_t *ref_C, *test_C;
+  posix_memalign((void **)&ref_C, 64, C_size * sizeof(*ref_C));
+  posix_memalign((void **)&test_C, 64, (C_size + kGuard) * sizeof(*test_C));
+  std::fill(test_C + C_size, test_C + C_size + kGuard, -1);
+  MultiplyRef(A_quant, B_quant, ref_C, A_rows, width, B_cols,
+              [](int32_t sum, int, int) { return sum; });
+  gemmology::Multiply(A_prep, B_prep, A_rows, width, B_cols,
+                      gemmology::callbacks::Write(test_C), TestEngine());
+
+  bool res = memcmp(ref_C, test_C, C_size * sizeof(*test_C)) == 0;
+  if (!res)
+    std::cerr << "signed multiply mismatch\n";
+  if (std::any_of(test_C + C_size, test_C + C_size + kGuard,
+                  [](int32_t value) { return value != -1; })) {
+    std::cerr << "signed multiply wrote past the output\n";
+    res = false;
+  }
+
+  free(A);
+  free(B);
+  free(A_prep);
+  free(A_quant);
+  free(B_quant);
+  free(B_prep);
+  free(ref_C);
+  free(test_C);
+  return res;
+}
+
+bool TestMultiplyStrided(int A_rows, int width, int B_cols) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+  setup.ReferenceMultiply();
+
+  // A is a block of columns of a larger matrix, and so is C.
+  const int A_cols = width + 13, A_col0 = 5;
+  const int C_cols = B_cols + 11, C_col0 = 3;
+  const int C_size = A_rows * C_cols;
+  float *A;
+  posix_memalign((void **)&A, 64, A_rows * A_cols * sizeof(*A));
+  setup.Generate(A, A_rows * A_cols);
+  for (int r = 0; r < A_rows; ++r)
+    std::copy_n(setup.A + r * width, width, A + r * A_cols + A_col0);
+
+  bool res = true;
+
+  // Same prepared A, read from the block of columns.
+  const int padded_width = PaddedWidth(width);
+  gemmology::Shift::PrepareAStrided(A + A_col0, setup.A_prep,
+                                    setup.quant_mult, A_rows, width, A_cols);
+  // Same prepared A, with rows further apart.
+  const int lda = padded_width + 64;
+  uint8_t *A_strided;
+  posix_memalign((void **)&A_strided, 64, A_rows * lda * sizeof(*A_strided));
+  for (int r = 0; r < A_rows; ++r)
+    std::copy_n(setup.A_prep + r * padded_width, padded_width,
+                A_strided + r * lda);
+
+  float *test_C;
+  posix_memalign((void **)&test_C, 64, C_size * sizeof(*test_C));
+  std::fill(test_C, test_C + C_size, -1.0f);
+  gemmology::Shift::MultiplyStrided(
+      A_strided, setup.B_prep, A_rows, width, B_cols, lda,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+          setup.unquant_mult, setup.bias, test_C + C_col0, C_cols),
+      TestEngine());
+
+  for (int r = 0; r < A_rows; ++r) {
+    for (int c = 0; c < C_cols; ++c) {
+      const bool inside = c >= C_col0 && c < C_col0 + B_cols;
+      const float expected =
+          inside ? setup.ref_C[r * B_cols + c - C_col0] : -1.0f;
+      if (test_C[r * C_cols + c] != expected) {
+        std::cerr << "strided multiply mismatch at " << r << ", " << c
+                  << "\n";
+        res = false;
+        r = A_rows;
+        break;
+      }
+    }
+  }
+
+  free(A);
+  free(A_strided);
+  free(test_C);
+  return res;
+}
+
+bool TestMultiplyUnaligned(int A_rows, int width, int B_cols) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+
+  // Bias and output one float off their alignment, as from a generic
+  // allocator.
+  std::vector<float> bias_storage(B_cols + 1), C_storage(setup.C_size + 1);
+  float *unaligned_bias = bias_storage.data() + 1;
+  float *unaligned_C = C_storage.data() + 1;
+  std::copy_n(setup.bias, B_cols, unaligned_bias);
+
+  float alpha = 2.0f;
+  float unquant_mult_forprep = (-1) * (alpha) * (alpha) / (127.0f);
+
+  gemmology::Shift::PrepareBias(
+      setup.B_prep, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWrite(
+          unquant_mult_forprep, setup.bias, setup.bias));
+  setup.ReferenceMultiply();
+
+  gemmology::Shift::PrepareBias(
+      setup.B_prep, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWriteUnaligned(
+          unquant_mult_forprep, unaligned_bias, unaligned_bias));
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndWriteUnaligned(
+          setup.unquant_mult, unaligned_bias, unaligned_C),
+      TestEngine());
+
+  bool res = std::equal(setup.ref_C, setup.ref_C + setup.C_size, unaligned_C);
+  if (!res)
+    std::cerr << "unaligned multiply mismatch\n";
+  return res;
+}
+
+bool TestMultiplyAccumulate(int A_rows, int width, int B_cols, float beta) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+  float *residual;
+  posix_memalign((void **)&residual, 64, setup.C_size * sizeof(*residual));
+  setup.Generate(residual, setup.C_size);
+
+  setup.ReferenceMultiply();
+  if (beta == 0.0f) {
+    // C is then not read at all, so even NaN must not get through.
+    std::fill_n(setup.test_C, setup.C_size,
+                std::numeric_limits<float>::quiet_NaN());
+  } else {
+    for (int i = 0; i < setup.C_size; ++i)
+      setup.ref_C[i] += beta * residual[i];
+    std::copy_n(residual, setup.C_size, setup.test_C);
+  }
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndAccumulate(
+          setup.unquant_mult, setup.bias, setup.test_C, beta),
+      TestEngine());
+
+  bool res = CompareEps(setup.ref_C, setup.test_C, setup.C_size, 0.0001f);
+  // CompareEps lets NaN through.
+  if (std::any_of(setup.test_C, setup.test_C + setup.C_size,
+                  [](float x) { return std::isnan(x); })) {
+    std::cerr << "Accumulate left NaN in C\n";
+    res = false;
+  }
+
+  free(residual);
+  return res;
+}
+
+template <class Activation, class Reference>
+bool TestMultiplyActivation(int A_rows, int width, int B_cols,
+                            Reference reference) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+
+  setup.ReferenceMultiply();
+  std::transform(setup.ref_C, setup.ref_C + setup.C_size, setup.ref_C,
+                 reference);
+
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndActivateAndWrite<Activation>(
+          setup.unquant_mult, setup.bias, setup.test_C),
+      TestEngine());
+
+  return CompareEps(setup.ref_C, setup.test_C, setup.C_size, 0.001f);
+}
+
+bool TestMultiplyRequantize(int A_rows, int width, int B_cols) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+  // The output is the prepared A of a next layer of width B_cols.
+  const int ldc = PaddedWidth(B_cols);
+  float next_quant_mult = 127.0f / 8.0f;
+
+  uint8_t *ref_next, *test_next;
+  posix_memalign((void **)&ref_next, 64, A_rows * ldc * sizeof(*ref_next));
+  posix_memalign((void **)&test_next, 64, A_rows * ldc * sizeof(*test_next));
+
+  // Reference: write floats, then prepare them for the next layer.
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndActivateAndWrite<
+          gemmology::callbacks::ReLU>(setup.unquant_mult, setup.bias,
+                                      setup.ref_C),
+      TestEngine());
+  gemmology::Shift::PrepareA(setup.ref_C, ref_next, next_quant_mult, A_rows,
+                             B_cols);
+
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizeAndAddBiasAndRequantize<
+          gemmology::callbacks::ReLU>(setup.unquant_mult, setup.bias,
+                                      test_next, next_quant_mult, ldc),
+      TestEngine());
+
+  bool res = true;
+  for (int r = 0; r < A_rows && res; ++r) {
+    for (int c = 0; c < B_cols; ++c) {
+      // Allow for a different rounding of the floats on the way.
+      if (std::abs(ref_next[r * ldc + c] - test_next[r * ldc + c]) > 1) {
+        std::cerr << "requantize mismatch at " << r << ", " << c << ": "
+                  << int(ref_next[r * ldc + c]) << " vs "
+                  << int(test_next[r * ldc + c]) << "\n";
+        res = false;
+        break;
+      }
+    }
+  }
+
+  free(ref_next);
+  free(test_next);
+  return res;
+}
+
+bool TestMultiplyPerColumn(int A_rows, int width, int B_cols,
+                           bool transposed = false) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+  const int B_size = setup.B_size, C_size = setup.C_size;
+  float *A = setup.A, *B = setup.B, *bias = setup.bias;
+  // Columns of B of very different magnitudes, from 1/8 to 8.
+  std::vector<float> scales(B_cols);
+  for (int c = 0; c < B_cols; ++c)
+    scales[c] = std::ldexp(1.0f, c % 7 - 3);
+  for (int i = 0; i < B_size; ++i)
+    B[i] *= scales[i % B_cols];
+
+  float quant_mult = setup.quant_mult;
+  std::vector<float> quant_mults(B_cols), unquant_mults(B_cols),
+      unquant_mults_forprep(B_cols);
+  for (int c = 0; c < B_cols; ++c) {
+    // Keep the same headroom as quant_mult: uint8 times int8 pairs saturate
+    // 16-bit integers otherwise.
+    quant_mults[c] = 127.0f / (2.0f * scales[c]);
+    unquant_mults[c] = 1.0f / (quant_mult * quant_mults[c]);
+    unquant_mults_forprep[c] = -127.0f * unquant_mults[c];
+  }
+
+  if (transposed) {
+    std::vector<float> B_transposed(B_size);
+    for (int r = 0; r < width; ++r)
+      for (int c = 0; c < B_cols; ++c)
+        B_transposed[c * width + r] = B[r * B_cols + c];
+    gemmology::PrepareBTransposedPerColumn(
+        B_transposed.data(), setup.B_prep, quant_mults.data(), width, B_cols);
+  } else {
+    gemmology::PrepareBPerColumn(B, setup.B_prep, quant_mults.data(), width,
+                                 B_cols);
+  }
+
+  // Integer reference, each column of B quantized with its own multiplier.
+  std::vector<float> B_scaled(B_size);
+  for (int i = 0; i < B_size; ++i)
+    B_scaled[i] = B[i] * quant_mults[i % B_cols];
+  int8_t *A_quant, *B_quant;
+  posix_memalign((void **)&A_quant, 64, setup.A_size * sizeof(*A_quant));
+  posix_memalign((void **)&B_quant, 64, B_size * sizeof(*B_quant));
+  gemmology::Quantize(A, A_quant, quant_mult, setup.A_size);
+  gemmology::Quantize(B_scaled.data(), B_quant, 1.0f, B_size);
+  std::vector<float> float_C(C_size);
+  MultiplyRef(A_quant, B_quant, setup.ref_C, A_rows, width, B_cols,
+              [&](int32_t sum, int, int j) {
+                return sum * unquant_mults[j] + bias[j];
+              });
+  MultiplyRef(A, B, float_C.data(), A_rows, width, B_cols,
+              [&](double sum, int, int j) {
+                return static_cast<float>(sum) + bias[j];
+              });
+
+  float *ref_C = setup.ref_C, *test_C = setup.test_C;
+  gemmology::Shift::PrepareBias(
+      setup.B_prep, width, B_cols,
+      gemmology::callbacks::UnquantizePerColumnAndAddBiasAndWrite(
+          unquant_mults_forprep.data(), bias, bias));
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizePerColumnAndAddBiasAndWrite(
+          unquant_mults.data(), bias, test_C),
+      TestEngine());
+
+  bool res = true;
+  for (int i = 0; i < C_size && res; ++i) {
+    // Bias correction cancels out large terms, hence an absolute tolerance.
+    if (std::fabs(ref_C[i] - test_C[i]) > 0.01f) {
+      std::cerr << "per column mismatch at " << i << ": " << ref_C[i]
+                << " vs " << test_C[i] << "\n";
+      res = false;
+    }
+    // The error follows the magnitude of each column, not of the largest.
+    if (std::fabs(float_C[i] - test_C[i]) >
+        0.05f * std::sqrt(float(width)) * scales[i % B_cols]) {
+      std::cerr << "per column inaccurate at " << i << ": " << float_C[i]
+                << " vs " << test_C[i] << "\n";
+      res = false;
+    }
+  }
+
+  free(A_quant);
+  free(B_quant);
+  return res;
+}
+
+bool TestMultiplyDynamic(int A_rows, int width, int B_cols) {
+  ShiftMultiplySetup setup(A_rows, width, B_cols);
+  const int A_size = setup.A_size, B_size = setup.B_size,
+            C_size = setup.C_size;
+  float *A = setup.A, *B = setup.B, *bias = setup.bias;
+  // Rows of A of very different magnitudes, from 1/4 to 4.
+  std::vector<float> scales(A_rows);
+  for (int r = 0; r < A_rows; ++r)
+    scales[r] = std::ldexp(1.0f, r % 5 - 2);
+  for (int i = 0; i < A_size; ++i)
+    A[i] *= scales[i / width];
+
+  float quant_mult = setup.quant_mult;
+  std::vector<float> col_unquant_mults(B_cols, 1.0f / quant_mult),
+      col_unquant_mults_forprep(B_cols, -127.0f / quant_mult);
+
+  std::vector<float> row_unquant_mults(A_rows);
+  gemmology::Shift::PrepareADynamic(A, setup.A_prep, row_unquant_mults.data(),
+                                    A_rows, width);
+
+  // Integer reference, each row of A quantized with its own multiplier.
+  // Rows of width bytes are not aligned, so round A here rather than with
+  // Quantize, the same way: to nearest even, clipped to [-127, 127].
+  int8_t *A_quant, *B_quant;
+  posix_memalign((void **)&A_quant, 64, A_size * sizeof(*A_quant));
+  posix_memalign((void **)&B_quant, 64, B_size * sizeof(*B_quant));
+  for (int i = 0; i < A_size; ++i) {
+    float value = std::nearbyint(A[i] * (1.0f / row_unquant_mults[i / width]));
+    A_quant[i] = static_cast<int8_t>(std::clamp(value, -127.0f, 127.0f));
+  }
+  gemmology::Quantize(B, B_quant, quant_mult, B_size);
+  std::vector<float> float_C(C_size);
+  MultiplyRef(A_quant, B_quant, setup.ref_C, A_rows, width, B_cols,
+              [&](int32_t sum, int i, int j) {
+                return sum * row_unquant_mults[i] / quant_mult + bias[j];
+              });
+  MultiplyRef(A, B, float_C.data(), A_rows, width, B_cols,
+              [&](double sum, int, int j) {
+                return static_cast<float>(sum) + bias[j];
+              });
+
+  float *correction;
+  posix_memalign((void **)&correction, 64, B_cols * sizeof(*correction));
+  float *ref_C = setup.ref_C, *test_C = setup.test_C;
+  gemmology::Shift::PrepareBias(
+      setup.B_prep, width, B_cols,
+      gemmology::callbacks::UnquantizePerColumnAndWrite(
+          col_unquant_mults_forprep.data(), correction));
+  gemmology::Shift::Multiply(
+      setup.A_prep, setup.B_prep, A_rows, width, B_cols,
+      gemmology::callbacks::UnquantizePerRowAndColumnAndAddBiasAndWrite(
+          row_unquant_mults.data(), col_unquant_mults.data(), correction,
+          bias, test_C),
+      TestEngine());
+
+  bool res = true;
+  for (int i = 0; i < C_size && res; ++i) {
+    // The shift correction cancels out large terms.
+    if (std::fabs(ref_C[i] - test_C[i]) > 0.01f) {
+      std::cerr << "dynamic mismatch at " << i << ": " << ref_C[i] << " vs "
+                << test_C[i] << "\n";
+      res = false;
+    }
+    // The error follows the magnitude of each row, not of the largest.
+    if (std::fabs(float_C[i] - test_C[i]) >
+        0.05f * std::sqrt(float(width)) * scales[i / B_cols]) {
+      std::cerr << "dynamic inaccurate at " << i << ": " << float_C[i]
+                << " vs " << test_C[i] << "\n";
+      res = false;
+    }
+  }
+
+  free(A_quant);
+  free(B_quant);
+  free(correction);
+  return res;
+}
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+bool TestMultiplyAMX(int A_rows, int width, int B_cols) {
+  int A_size = A_rows * width;
+  int B_size = width * B_cols;
+  int C_size = A_rows * B_cols;
+  float *A, *B;
+  posix_memalign((void **)&A, 64, A_size * sizeof(*A));
+  posix_memalign((void **)&B, 64, B_size * sizeof(*B));
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+  std::generate(A, A + A_size, [&]() { return dist(gen); });
+  std::generate(B, B + B_size, [&]() { return dist(gen); });
+
+  float quant_mult = 127.0f / 2.0f;
+
+  uint8_t *A_prep;
+  int8_t *B_prep, *B_amx;
+  posix_memalign((void **)&A_prep, 64,
+                 A_rows * PaddedWidth(width) * sizeof(*A_prep));
+  posix_memalign((void **)&B_prep, 64,
+                 PreparedSize(width, B_cols) * sizeof(*B_prep));
+  posix_memalign((void **)&B_amx, 64,
+                 PreparedSize(width, B_cols) * sizeof(*B_amx));
+  gemmology::Shift::PrepareA(A, A_prep, quant_mult, A_rows, width);
+  gemmology::PrepareB(B, B_prep, quant_mult, width, B_cols);
+  gemmology::PrepareBAMX(B, B_amx, quant_mult, width, B_cols);
+
+  int32_t *ref_C, *test_C;
+  posix_memalign((void **)&ref_C, 64, C_size * sizeof(*ref_C));
+  posix_memalign((void **)&test_C, 64, C_size * sizeof(*test_C));
+  gemmology::Shift::Multiply(A_prep, B_prep, A_rows, width, B_cols,
+                             gemmology::callbacks::Write(ref_C), TestEngine());
+  gemmology::Shift::MultiplyAMX(A_prep, B_amx, A_rows, width, B_cols,
+                                gemmology::callbacks::Write(test_C),
+                                TestEngine());
+  bool res = memcmp(ref_C, test_C, C_size * sizeof(*test_C)) == 0;
+  if (!res)
+    std::cerr << "AMX multiply mismatch\n";
+
+  gemmology::Shift::PrepareBias(B_prep, width, B_cols,
+                                gemmology::callbacks::Write(ref_C));
+  gemmology::Shift::PrepareBiasAMX(B_amx, width, B_cols,
+                                   gemmology::callbacks::Write(test_C));
+  if (memcmp(ref_C, test_C, B_cols * sizeof(*test_C)) != 0) {
+    std::cerr << "AMX bias mismatch\n";
+    res = false;
+  }
+
+  free(A);
+  free(B);
+  free(A_prep);
+  free(B_prep);
+  free(B_amx);
+  free(ref_C);
+  free(test_C);
+  return res;
+}
+#endif
+
 bool TestPrepareBias(int rows, int cols) {
   std::mt19937 gen;
   // Go somewhat out of range too.
@@ -374,7 +1124,8 @@ bool TestPrepareBias(int rows, int cols) {
   float quant_mult = 127 / alpha;
 
   int8_t *B_prep;
-  posix_memalign((void **)&B_prep, 64, inputB_size * sizeof(*B_prep));
+  posix_memalign((void **)&B_prep, 64,
+                 PreparedSize(rows, cols) * sizeof(*B_prep));
 
   int8_t *B_quant;
   posix_memalign((void **)&B_quant, 64, inputB_size * sizeof(*B_quant));
@@ -438,6 +1189,18 @@ int main() {
     return 1;
   if (!TestSelectColumnsB(512, 512))
     return 1;
+  // Columns of B, and selected columns, not a multiple of 8.
+  if (!TestSelectColumnsB(256, 100, 21))
+    return 1;
+  if (!TestSelectColumnsB(1000, 64, 24))
+    return 1;
+
+  if (!TestPrepareBEngine(256, 256))
+    return 1;
+  if (!TestPrepareBEngine(1000, 100))
+    return 1;
+  if (!TestPrepareBEngine(100, 27))
+    return 1;
 
   if (!TestPrepareA(64, 64))
     return 1;
@@ -454,6 +1217,11 @@ int main() {
     return 1;
   if (!TestPrepareBias(512, 512))
     return 1;
+  if (!TestPrepareBias(256, 100))
+    return 1;
+  // Shared dimension not a multiple of the register size.
+  if (!TestPrepareBias(1000, 64))
+    return 1;
 
   if (!TestMultiplyShiftInt(8, 256, 256, 0.0001f, 0.54f, 0.17f, 0.0001f))
     return 1;
@@ -469,6 +1237,154 @@ int main() {
     return 1;
   if (!TestMultiplyShiftInt(2, 512, 512, 0.0001f, 0.74f, 0.17f, 0.0001f))
     return 1;
+  // Few columns of B, many rows of A: rows get split across tasks too.
+  if (!TestMultiplyShiftInt(256, 256, 16, 0.0001f, 0.74f, 0.17f, 0.0001f))
+    return 1;
+  if (!TestMultiplyShiftInt(37, 256, 64, 0.0001f, 0.74f, 0.17f, 0.0001f))
+    return 1;
+  // Columns of B not a multiple of 8.
+  if (!TestMultiplyShiftInt(8, 256, 100, 0.0001f, 0.74f, 0.17f, 0.0001f))
+    return 1;
+  if (!TestMultiplyShiftInt(1, 256, 13, 0.0001f, 0.74f, 0.17f, 0.0001f))
+    return 1;
+  // Shared dimension not a multiple of the register size.
+  if (!TestMultiplyShiftInt(8, 1000, 64, 0.0001f, 1.66f, 0.46f, 0.0001f))
+    return 1;
+  if (!TestMultiplyShiftInt(5, 100, 27, 0.0001f, 0.74f, 0.17f, 0.0001f))
+    return 1;
+
+  if (!TestMultiplyBlocking(1, 4096, 64))
+    return 1;
+  if (!TestMultiplyBlocking(3, 2048, 16))
+    return 1;
+  if (!TestMultiplyBlocking(8, 256, 256))
+    return 1;
+  if (!TestMultiplyBlocking(17, 1024, 512))
+    return 1;
+  if (!TestMultiplyBlocking(1, 512, 264))
+    return 1;
+  if (!TestMultiplyBlocking(1, 2048, 1024))
+    return 1;
+  if (!TestMultiplyBlocking(17, 1024, 300))
+    return 1;
+  if (!TestMultiplyBlocking(1, 512, 27))
+    return 1;
+  if (!TestMultiplyBlocking(3, 2048, 5))
+    return 1;
+  if (!TestMultiplyBlocking(9, 1576, 64))
+    return 1;
+  if (!TestMultiplyBlocking(1, 1000, 40))
+    return 1;
+  // Enough rows of A for the tasks of sliced products to be capped in rows.
+  if (!TestMultiplyBlocking(4200, 512, 8))
+    return 1;
+
+  if (!TestMultiplyEmptyWidth(8, 64))
+    return 1;
+  if (!TestMultiplyEmptyWidth(1, 64))
+    return 1;
+
+  if (!TestMultiplyInt(8, 256, 256))
+    return 1;
+  if (!TestMultiplyInt(37, 512, 64))
+    return 1;
+  if (!TestMultiplyInt(1, 1024, 264))
+    return 1;
+  if (!TestMultiplyInt(37, 512, 61))
+    return 1;
+  if (!TestMultiplyInt(1, 1024, 259))
+    return 1;
+  if (!TestMultiplyInt(7, 1000, 24))
+    return 1;
+  if (!TestMultiplyInt(1, 33, 13))
+    return 1;
+
+  if (!TestMultiplyStrided(8, 256, 64))
+    return 1;
+  if (!TestMultiplyStrided(33, 1000, 27))
+    return 1;
+  if (!TestMultiplyStrided(1, 100, 24))
+    return 1;
+
+  if (!TestMultiplyUnaligned(8, 256, 64))
+    return 1;
+  if (!TestMultiplyUnaligned(1, 512, 256))
+    return 1;
+  if (!TestMultiplyUnaligned(17, 100, 27))
+    return 1;
+
+  if (!TestMultiplyAccumulate(8, 256, 64, 1.0f))
+    return 1;
+  if (!TestMultiplyAccumulate(1, 512, 256, 0.5f))
+    return 1;
+  if (!TestMultiplyAccumulate(17, 100, 27, -2.0f))
+    return 1;
+  if (!TestMultiplyAccumulate(17, 100, 27, 0.0f))
+    return 1;
+
+  auto relu = [](float x) { return std::max(x, 0.f); };
+  auto gelu = [](float x) {
+    return 0.5f * x * (1.f + std::erf(x / std::sqrt(2.f)));
+  };
+  auto gelu_tanh = [](float x) {
+    return 0.5f * x *
+           (1.f + std::tanh(std::sqrt(2.f / 3.14159265f) *
+                            (x + 0.044715f * x * x * x)));
+  };
+  auto silu = [](float x) { return x / (1.f + std::exp(-x)); };
+  if (!TestMultiplyActivation<gemmology::callbacks::ReLU>(8, 256, 64, relu))
+    return 1;
+  if (!TestMultiplyActivation<gemmology::callbacks::GELU>(8, 256, 64, gelu))
+    return 1;
+  if (!TestMultiplyActivation<gemmology::callbacks::GELUTanh>(8, 256, 64,
+                                                              gelu_tanh))
+    return 1;
+  if (!TestMultiplyActivation<gemmology::callbacks::SiLU>(8, 256, 64, silu))
+    return 1;
+  if (!TestMultiplyActivation<gemmology::callbacks::GELU>(1, 100, 27, gelu))
+    return 1;
+
+  if (!TestMultiplyRequantize(8, 256, 64))
+    return 1;
+  if (!TestMultiplyRequantize(1, 512, 256))
+    return 1;
+  if (!TestMultiplyRequantize(17, 100, 27))
+    return 1;
+
+  if (!TestMultiplyPerColumn(8, 256, 64))
+    return 1;
+  if (!TestMultiplyPerColumn(8, 256, 64, true))
+    return 1;
+  if (!TestMultiplyPerColumn(1, 512, 256))
+    return 1;
+  if (!TestMultiplyPerColumn(17, 100, 27))
+    return 1;
+  if (!TestMultiplyPerColumn(17, 100, 27, true))
+    return 1;
+
+  if (!TestMultiplyDynamic(8, 256, 64))
+    return 1;
+  if (!TestMultiplyDynamic(1, 512, 256))
+    return 1;
+  if (!TestMultiplyDynamic(17, 100, 27))
+    return 1;
+
+#if defined(__AMX_INT8__) && defined(__AVX512VNNI__)
+  if (!TestMultiplyAMX(40, 256, 56))
+    return 1;
+  if (!TestMultiplyAMX(64, 512, 64))
+    return 1;
+  if (!TestMultiplyAMX(3, 128, 24))
+    return 1;
+  if (!TestMultiplyAMX(1, 64, 8))
+    return 1;
+  if (!TestMultiplyAMX(40, 256, 60))
+    return 1;
+  if (!TestMultiplyAMX(3, 128, 29))
+    return 1;
+  if (!TestMultiplyAMX(33, 1000, 40))
+    return 1;
+#endif
 
   return 0;
 }
@@ -1,4 +1,5 @@
 #include "gemmology.h"
+#include "test_engine.h"
 
 #include <cmath>
 #include <cstring>
@@ -9,18 +10,21 @@ namespace {
 void PrepareBQuantizedTransposedRef(const int8_t* input, int8_t* output, int B_transposed_cols, int B_transposed_rows) {
   constexpr int vec_len = sizeof(xsimd::batch<int8_t>) / sizeof(int8_t);
 
+  // The last rows, if B_transposed_rows is not a multiple of 8, are padded with
+  // zeros, and so are the rows, up to a multiple of the register size.
   auto output_it = output;
   for (int r = 0; r < B_transposed_rows; r += 8)
     for (int c = 0; c < B_transposed_cols; c += vec_len)
       for (int ri = 0; ri < 8; ++ri)
         for (int ci = 0; ci < vec_len; ++ci)
-          *output_it++ = input[(r + ri) * B_transposed_cols + c + ci];
+          *output_it++ = r + ri < B_transposed_rows && c + ci < B_transposed_cols ? input[(r + ri) * B_transposed_cols + c + ci] : 0;
 }
 
 bool Test(const int8_t * input, int B_rows, int B_cols) {
   bool success = true;
 
-  int input_size = B_rows * B_cols;
+  constexpr int vec_len = sizeof(xsimd::batch<int8_t>) / sizeof(int8_t);
+  int input_size = (B_rows + vec_len - 1) / vec_len * vec_len * ((B_cols + 7) / 8 * 8);
 
   int8_t * output;
   posix_memalign((void**)&output, 64, input_size * sizeof(*output));
@@ -37,6 +41,15 @@ bool Test(const int8_t * input, int B_rows, int B_cols) {
       break;
     }
   }
+
+  // Same, blocks of columns being spread across the engine.
+  std::fill(output, output + input_size, 0);
+  gemmology::PrepareBQuantizedTransposed(input, output, B_rows, B_cols,
+                                         TestEngine());
+  if (!std::equal(output, output + input_size, reference)) {
+    std::cerr << "Error with an execution engine" << std::endl;
+    success = false;
+  }
   free(output);
   free(reference);
   return success;
@@ -64,5 +77,9 @@ int main() {
     return 1;
   if(!TestMany(512, 512))
     return 1;
+  if(!TestMany(64, 61))
+    return 1;
+  if(!TestMany(1000, 24))
+    return 1;
   return 0;
 }
@@ -1,4 +1,5 @@
 #include "gemmology.h"
+#include "test_engine.h"
 
 #include <cmath>
 #include <cstring>
@@ -11,12 +12,16 @@ namespace {
 void PrepareBTransposedRef(const float* input, int8_t* output, float quant_mult, int B_transposed_cols, int B_transposed_rows) {
   constexpr int vec_len = sizeof(xsimd::batch<int8_t>) / sizeof(int8_t);
 
-  for (int i = 0; i < B_transposed_rows * B_transposed_cols / 8; i += vec_len)
+  // The last rows, if B_transposed_rows is not a multiple of 8, are padded with
+  // zeros, and so are the rows, up to a multiple of the register size.
+  int padded_rows = (B_transposed_rows + 7) / 8 * 8;
+  int padded_cols = (B_transposed_cols + vec_len - 1) / vec_len * vec_len;
+  for (int i = 0; i < padded_rows * padded_cols / 8; i += vec_len)
     for (int j = 0; j < 8; ++j)
       for (int k = 0; k < vec_len; ++k) {
-        int col = (i + k) % B_transposed_cols;
-        int row = 8 * ((i + k) / B_transposed_cols) + j;
-        *output++ = static_cast<int8_t>(input[row * B_transposed_cols + col] * quant_mult);
+        int col = (i + k) % padded_cols;
+        int row = 8 * ((i + k) / padded_cols) + j;
+        *output++ = row < B_transposed_rows && col < B_transposed_cols ? static_cast<int8_t>(input[row * B_transposed_cols + col] * quant_mult) : 0;
       }
 }
 
@@ -24,7 +29,8 @@ bool Test(const float* input, int B_rows, int B_cols, float quant_mult) {
   bool success = true;
 
   int8_t *output;
-  int input_size =  B_rows * B_cols;
+  constexpr int vec_len = sizeof(xsimd::batch<int8_t>) / sizeof(int8_t);
+  int input_size =  (B_rows + vec_len - 1) / vec_len * vec_len * ((B_cols + 7) / 8 * 8);
   posix_memalign((void**)&output, 64, input_size * sizeof(*output));
   PrepareBTransposed(input, output, quant_mult, B_rows, B_cols);
 
@@ -32,7 +38,7 @@ bool Test(const float* input, int B_rows, int B_cols, float quant_mult) {
   posix_memalign((void**)&reference, 64, input_size * sizeof(*reference));
   PrepareBTransposedRef(input, reference, quant_mult, B_rows, B_cols);
 
-  for (std::size_t i = 0; i < B_rows * B_cols * sizeof(*output); ++i) {
+  for (std::size_t i = 0; i < input_size * sizeof(*output); ++i) {
     if (output[i] != reference[i]) {
       std::cerr << "Error at " << i << ", output = " << int(output[i]) << ", reference = " << int(reference[i]) << std::endl;
       success = false;
@@ -40,6 +46,14 @@ bool Test(const float* input, int B_rows, int B_cols, float quant_mult) {
     }
   }
 
+  // Same, blocks of columns being spread across the engine.
+  std::fill(output, output + input_size, 0);
+  PrepareBTransposed(input, output, quant_mult, B_rows, B_cols, TestEngine());
+  if (!std::equal(output, output + input_size, reference)) {
+    std::cerr << "Error with an execution engine" << std::endl;
+    success = false;
+  }
+
   free(output);
   free(reference);
   return success;
@@ -67,6 +81,10 @@ int main() {
     return 1;
   if(!TestMany(512, 512, 2.0f))
     return 1;
+  if(!TestMany(16, 61, 2.0f))
+    return 1;
+  if(!TestMany(1000, 24, 2.0f))
+    return 1;
   return 0;
 }
 
@@ -1,8 +1,12 @@
 #include "gemmology.h"
+#include "test_engine.h"
 
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <vector>
 
 namespace {
 
@@ -51,6 +55,18 @@ bool Test(const float *input_unaligned, float quant_mult, std::size_t size) {
     }
   }
 
+  // QuantizeU gives the same values, shifted by 127.
+  uint8_t *test_u;
+  posix_memalign((void**)&test_u, 64, size * sizeof(*test_u));
+  gemmology::QuantizeU(input, test_u, quant_mult, size);
+
+  for (std::size_t i = 0; i < size; ++i) {
+    if (IsOff(input[i] * quant_mult + 127, ref[i] + 127, int(test_u[i]))) {
+      std::cerr << "Error at " << i << " from " << input[i] << '*' << quant_mult << '=' << (input[i]*quant_mult) << " ref = " << static_cast<int>(ref[i]) << " + 127 test_u = " << static_cast<int>(test_u[i]) << "\n";
+      success = false;
+    }
+  }
+
   for(size_t i = 0; i < batch_padding; ++i) {
     if(((char*)input)[sizeof(*input) * size +i] != sentinel) {
       std::cerr << "Sentinel value used for padding changed :-/\n";
@@ -61,6 +77,7 @@ bool Test(const float *input_unaligned, float quant_mult, std::size_t size) {
   free(input);
   free(ref);
   free(test);
+  free(test_u);
   return success;
 }
 
@@ -84,6 +101,98 @@ bool TestMany(std::size_t grow) {
   return true;
 }
 
+// QuantizeUAndWrite, fed a batch at a time, writes the same bytes as QuantizeU,
+// NaN and out of range values included.
+bool TestQuantizeUAndWrite(float quant_mult) {
+  using batchf32 = xsimd::batch<float, gemmology::default_arch>;
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  constexpr std::size_t size = 35;
+  float input[size] = {
+    -32769.f, -32768.f, -32767.f, -129.f, -128.f, -127.f, -1.f, 0.f, 1.f,
+    126.f, 127.f, 128.f, 129.f, 32766.f, 32768.f, 32769.f, -1.9f, -1.5f, -1.1f,
+    -1.f, -0.9f, -0.5f, -0.1f, 0.0f, 0.1f, 0.5f, 0.9f, 1.0f, 1.1f, 1.5f, 1.9f,
+    16056.8f, 2.5f, nan, -nan};
+
+  uint8_t *ref;
+  posix_memalign((void**)&ref, 64, size * sizeof(*ref));
+  gemmology::QuantizeU(input, ref, quant_mult, size);
+
+  uint8_t test[size];
+  gemmology::callbacks::QuantizeUAndWrite write{test, quant_mult, size};
+  for (std::size_t c = 0; c < size; c += batchf32::size) {
+    alignas(64) float padded[batchf32::size] = {};
+    std::copy_n(input + c, std::min(batchf32::size, size - c), padded);
+    write(batchf32::load_aligned(padded), 0, c, size);
+  }
+
+  bool success = true;
+  for (std::size_t i = 0; i < size; ++i) {
+    if (ref[i] != test[i]) {
+      std::cerr << "QuantizeUAndWrite error at " << i << " from " << input[i]
+                << '*' << quant_mult << " QuantizeU = " << int(ref[i])
+                << " test = " << int(test[i]) << "\n";
+      success = false;
+    }
+  }
+  free(ref);
+  return success;
+}
+
+bool TestStatistics(std::size_t size) {
+  std::vector<float> input(size);
+  std::mt19937 gen;
+  std::uniform_real_distribution<float> dist(-1.0f, 3.0f);
+  for (auto &value : input)
+    value = dist(gen);
+  const float *begin = input.data(), *end = input.data() + size;
+
+  float max_abs = 0.f;
+  float low = std::numeric_limits<float>::infinity();
+  float high = -std::numeric_limits<float>::infinity();
+  double sum = 0., abs_sum = 0., squares = 0.;
+  for (float value : input) {
+    max_abs = std::max(max_abs, std::fabs(value));
+    low = std::min(low, value);
+    high = std::max(high, value);
+    sum += value;
+    abs_sum += std::fabs(value);
+    squares += double(value) * value;
+  }
+  const double mean = size ? sum / size : 0.;
+  const double abs_mean = size ? abs_sum / size : 0.;
+  const double stddev = size ? std::sqrt(squares / size - mean * mean) : 0.;
+  const double abs_stddev =
+      size ? std::sqrt(squares / size - abs_mean * abs_mean) : 0.;
+
+  bool success = true;
+  if (gemmology::MaxAbsolute(begin, end, TestEngine()) != max_abs) {
+    std::cerr << "MaxAbsolute error for size " << size << "\n";
+    success = false;
+  }
+  auto min_max = gemmology::MinMax(begin, end, TestEngine());
+  if (min_max.first != low || min_max.second != high) {
+    std::cerr << "MinMax error for size " << size << "\n";
+    success = false;
+  }
+  auto mean_std = gemmology::VectorMeanStd(begin, end, false, TestEngine());
+  if (std::fabs(mean_std.mean - mean) > 1e-4 ||
+      std::fabs(mean_std.stddev - stddev) > 1e-4) {
+    std::cerr << "VectorMeanStd error for size " << size << ": "
+              << mean_std.mean << ' ' << mean_std.stddev << " instead of "
+              << mean << ' ' << stddev << "\n";
+    success = false;
+  }
+  auto abs_mean_std = gemmology::VectorMeanStd(begin, end, true, TestEngine());
+  if (std::fabs(abs_mean_std.mean - abs_mean) > 1e-4 ||
+      std::fabs(abs_mean_std.stddev - abs_stddev) > 1e-4) {
+    std::cerr << "VectorMeanStd (absolute) error for size " << size << ": "
+              << abs_mean_std.mean << ' ' << abs_mean_std.stddev
+              << " instead of " << abs_mean << ' ' << abs_stddev << "\n";
+    success = false;
+  }
+  return success;
+}
+
 } // namespace
 
 int main() {
@@ -91,4 +200,10 @@ int main() {
     return 1;
   if(!TestMany(16))
     return 1;
+  for (float quant_mult : {1.0f, -1.0f, 32.0f})
+    if (!TestQuantizeUAndWrite(quant_mult))
+      return 1;
+  for (std::size_t size : {0, 1, 7, 33, 1000, 100000})
+    if (!TestStatistics(size))
+      return 1;
 }